@@ -5,10 +5,15 @@
 #pragma once
 
 
+#include "sdkconfig.h"
+
 #include <esp_err.h>
+#include <freertos/FreeRTOS.h>
 #include <driver/spi_master.h>
 #include <driver/gpio.h>
 
+#include "max7219_7221_capture.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,6 +23,70 @@ extern "C" {
 #define MAX7219_MIN_DIGIT 1   ///< A MAX7219 / MAX7221 can drive a minimum of 1 digit
 #define MAX7219_MAX_DIGIT 8   ///< A MAX7219 / MAX7221 can drive a maximum of 8 digits
 
+#define MAX7219_FRAME_INDEX(chainId, digit) ((((chainId) - 1) * MAX7219_MAX_DIGIT) + ((digit) - 1))   ///< Index of digit `digit` of device `chainId` in a frame buffer
+
+
+#if defined(CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH) && (CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH > 0)
+#define MAX7219_FIXED_CHAIN_LENGTH CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH  ///< Chain length fixed at compile time via `CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH`
+
+#ifdef __cplusplus
+    #define MAX7219_STATIC_ASSERT_(expr, msg) static_assert(expr, msg)
+#else
+    #define MAX7219_STATIC_ASSERT_(expr, msg) _Static_assert(expr, msg)
+#endif
+
+/**
+ * @brief Check at compile time that a constant chain ID is valid for the fixed chain length.
+ */
+#define MAX7219_STATIC_CHECK_CHAIN_ID(chainId) \
+    MAX7219_STATIC_ASSERT_(((chainId) >= 1) && ((chainId) <= MAX7219_FIXED_CHAIN_LENGTH), "Invalid chain ID")
+
+/**
+ * @brief Check at compile time that constant digit codes starting at `startChainId` / `startDigitId` fit in the fixed chain.
+ */
+#define MAX7219_STATIC_CHECK_DIGITS(startChainId, startDigitId, digitCodesCount) \
+    MAX7219_STATIC_ASSERT_(((startChainId) >= 1) && ((startChainId) <= MAX7219_FIXED_CHAIN_LENGTH) && \
+                           ((startDigitId) >= MAX7219_MIN_DIGIT) && ((startDigitId) <= MAX7219_MAX_DIGIT) && \
+                           ((digitCodesCount) > 0) && \
+                           ((digitCodesCount) <= ((MAX7219_FIXED_CHAIN_LENGTH - (startChainId)) * MAX7219_MAX_DIGIT) + (MAX7219_MAX_DIGIT - (startDigitId)) + 1), \
+                           "Invalid digit range")
+#endif
+
+
+// Driver context layout - Keep in sync with 'led_driver_max7219_context_t':
+//  * Pointers: function table and mutex (unless single owner), 7 handles and per feature state, one per optional feature enabled in menuconfig,
+//  * Scalars: SPI queue size, bus ownership policy, bus idle release delay and 6 bytes of narrow fields,
+//  * Command buffer: embedded for a fixed chain length (with alignment slack), otherwise a flag and a pointer or 2 inline commands
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    #define LED_DRIVER_MAX7219_BASE_POINTERS_ 7
+#else
+    #define LED_DRIVER_MAX7219_BASE_POINTERS_ 13
+#endif
+
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    #define LED_DRIVER_MAX7219_LATENCY_POINTERS_ 1
+#else
+    #define LED_DRIVER_MAX7219_LATENCY_POINTERS_ 0
+#endif
+
+#if CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+    #define LED_DRIVER_MAX7219_CAPTURE_POINTERS_ 1
+#else
+    #define LED_DRIVER_MAX7219_CAPTURE_POINTERS_ 0
+#endif
+
+#define LED_DRIVER_MAX7219_CONTEXT_POINTERS_ (LED_DRIVER_MAX7219_BASE_POINTERS_ + LED_DRIVER_MAX7219_LATENCY_POINTERS_ + LED_DRIVER_MAX7219_CAPTURE_POINTERS_)
+#define LED_DRIVER_MAX7219_CONTEXT_SCALARS_SIZE_ ((3 * sizeof(uint32_t)) + 6)
+
+#ifdef MAX7219_FIXED_CHAIN_LENGTH
+    #define LED_DRIVER_MAX7219_COMMANDS_SIZE_ ((2 * MAX7219_FIXED_CHAIN_LENGTH) + 3)
+#else
+    #define LED_DRIVER_MAX7219_COMMANDS_SIZE_ (1 + sizeof(void*))
+#endif
+
+#define LED_DRIVER_MAX7219_CONTEXT_SIZE ((LED_DRIVER_MAX7219_CONTEXT_POINTERS_ * sizeof(void*)) + LED_DRIVER_MAX7219_CONTEXT_SCALARS_SIZE_ + LED_DRIVER_MAX7219_COMMANDS_SIZE_)   ///< Size in bytes of the storage for a driver context. See `led_driver_max7219_init_static()`
+#define LED_DRIVER_MAX7219_DMA_BUFFER_SIZE(chainLength) (2 * (size_t)(chainLength))                         ///< Size in bytes of the DMA command buffer for a chain of `chainLength` devices. See `led_driver_max7219_init_static()`
+
 
 /**
  * @brief Handle to a MAX7219 / MAX7221 device.
@@ -168,6 +237,150 @@ typedef enum {
 
 
 
+/**
+ * @brief Priority class of a display update.
+ */
+typedef enum {
+    MAX7219_PRIORITY_URGENT = 0,      ///< Sent right after the chain transfer in progress, ahead of the remaining transfers of any other operation
+    MAX7219_PRIORITY_NORMAL = 1,      ///< Sent in order of driver access, like `led_driver_max7219_set_digit()`
+    MAX7219_PRIORITY_BACKGROUND = 2,  ///< Sent when the driver is idle or when the current operation completes. Later values replace earlier ones
+
+    MAX7219_PRIORITY_COUNT = 3        ///< Number of priority classes
+} max7219_priority_t;
+
+/**
+ * @brief Update latency per priority class. See `led_driver_max7219_get_priority_latency()`.
+ */
+typedef struct max7219_priority_latency {
+    uint32_t worst_us[MAX7219_PRIORITY_COUNT];  ///< Worst latency, in microseconds, between an update request and the end of the chain transfer carrying it
+    uint32_t count[MAX7219_PRIORITY_COUNT];     ///< Number of requests (urgent / normal) or batches of coalesced requests (background) measured
+} max7219_priority_latency_t;
+
+
+
+/**
+ * @brief Power policy. See `led_driver_max7219_set_power_policy()`.
+ */
+typedef struct max7219_power_policy {
+    bool shutdown_blank_devices;        ///< Put devices in normal mode whose eight digits are blank in shutdown mode and wake them up when a digit is lit
+    uint32_t idle_timeout_ms;           ///< Put all devices in normal mode in shutdown mode after this many milliseconds without operation, or 0 to disable
+} max7219_power_policy_t;
+
+
+
+/**
+ * @brief Driver operations traced by latency tracing. See `led_driver_max7219_get_latency_trace()`.
+ */
+typedef enum {
+    MAX7219_LATENCY_API_CONFIGURE_DECODE = 0,     ///< `led_driver_max7219_configure_chain_decode()` / `led_driver_max7219_configure_decode()`
+    MAX7219_LATENCY_API_CONFIGURE_SCAN_LIMIT = 1, ///< `led_driver_max7219_configure_chain_scan_limit()` / `led_driver_max7219_configure_scan_limit()`
+    MAX7219_LATENCY_API_SET_MODE = 2,             ///< `led_driver_max7219_set_chain_mode()` / `led_driver_max7219_set_mode()`
+    MAX7219_LATENCY_API_SET_INTENSITY = 3,        ///< `led_driver_max7219_set_chain_intensity()` / `led_driver_max7219_set_intensity()`
+    MAX7219_LATENCY_API_SET_DIGITS = 4,           ///< `led_driver_max7219_set_chain_digit()`, `led_driver_max7219_set_digit()`, `led_driver_max7219_set_digits()` and their variants
+    MAX7219_LATENCY_API_FLUSH = 5,                ///< `led_driver_max7219_flush()`
+    MAX7219_LATENCY_API_PLAY_SCRIPT = 6,          ///< `led_driver_max7219_play_script()`
+    MAX7219_LATENCY_API_SEND_WIRE_FRAMES = 7,     ///< `led_driver_max7219_send_wire_frames()`
+
+    MAX7219_LATENCY_API_COUNT = 8                 ///< Number of traced operations
+} max7219_latency_api_t;
+
+/**
+ * @brief Stages of a traced driver operation.
+ */
+typedef enum {
+    MAX7219_LATENCY_STAGE_MUTEX_WAIT = 0,         ///< Waiting for the driver mutex
+    MAX7219_LATENCY_STAGE_BUS_ACQUIRE = 1,        ///< Waiting for exclusive access to the SPI bus
+    MAX7219_LATENCY_STAGE_ENCODE = 2,             ///< Filling the command buffer, including drained urgent / background digits and power policy decisions
+    MAX7219_LATENCY_STAGE_TRANSMIT = 3,           ///< Sending chain transfers, or handing them to the bus coordinator
+    MAX7219_LATENCY_STAGE_TOTAL = 4,              ///< Whole operation, from the call to the last chain transfer
+
+    MAX7219_LATENCY_STAGE_COUNT = 5               ///< Number of traced stages
+} max7219_latency_stage_t;
+
+#define MAX7219_LATENCY_BUCKET_COUNT 20           ///< Number of buckets in a latency histogram
+
+/**
+ * @brief Fixed bucket latency histogram. Bucket 0 counts latencies under 1 µs, bucket 'n' counts latencies from 2^(n-1) to 2^n - 1 µs and the last bucket counts all longer latencies.
+ */
+typedef struct max7219_latency_histogram {
+    uint32_t buckets[MAX7219_LATENCY_BUCKET_COUNT];  ///< Number of samples per bucket
+    uint32_t count;                                  ///< Number of samples
+    uint32_t max_us;                                 ///< Longest latency in microseconds
+} max7219_latency_histogram_t;
+
+/**
+ * @brief Latency histograms of every stage of every traced operation. See `led_driver_max7219_get_latency_trace()`.
+ */
+typedef struct max7219_latency_trace {
+    max7219_latency_histogram_t histograms[MAX7219_LATENCY_API_COUNT][MAX7219_LATENCY_STAGE_COUNT];  ///< Histograms indexed by `max7219_latency_api_t` then `max7219_latency_stage_t`
+} max7219_latency_trace_t;
+
+
+
+/**
+ * @brief Shared SPI bus coordinator configuration. See `led_driver_max7219_bus_coordinator_create()`.
+ */
+typedef struct max7219_bus_coordinator_config {
+    uint8_t max_chains;                 ///< Maximum number of chains attached at the same time
+    uint8_t frames_per_chain;           ///< Number of chain transfers each chain can have waiting or in flight. A task writing to a chain blocks while all are used
+    uint8_t max_in_flight;              ///< Number of chain transfers queued to the SPI host at once, across chains. 2 or more lets the bus move from one transfer to the next without waiting for the coordinator task
+    UBaseType_t task_priority;          ///< Priority of the coordinator task
+    BaseType_t task_core_id;            ///< Core the coordinator task is pinned to, or `tskNO_AFFINITY`
+    uint32_t task_stack_size;           ///< Stack size of the coordinator task in bytes
+} max7219_bus_coordinator_config_t;
+
+/**
+ * @brief Shared SPI bus coordinator handle.
+ */
+typedef struct max7219_bus_coordinator* max7219_bus_coordinator_handle_t;
+
+
+
+/**
+ * @brief MAX7219 / MAX7221 registers, for register command scripts.
+ */
+typedef enum {
+    MAX7219_REGISTER_NOOP = 0x00,             ///< No-op
+    MAX7219_REGISTER_DIGIT_1 = 0x01,          ///< Digit 1
+    MAX7219_REGISTER_DIGIT_2 = 0x02,          ///< Digit 2
+    MAX7219_REGISTER_DIGIT_3 = 0x03,          ///< Digit 3
+    MAX7219_REGISTER_DIGIT_4 = 0x04,          ///< Digit 4
+    MAX7219_REGISTER_DIGIT_5 = 0x05,          ///< Digit 5
+    MAX7219_REGISTER_DIGIT_6 = 0x06,          ///< Digit 6
+    MAX7219_REGISTER_DIGIT_7 = 0x07,          ///< Digit 7
+    MAX7219_REGISTER_DIGIT_8 = 0x08,          ///< Digit 8
+    MAX7219_REGISTER_DECODE_MODE = 0x09,      ///< Decode mode, a `max7219_decode_mode_t`
+    MAX7219_REGISTER_INTENSITY = 0x0A,        ///< Intensity, a `max7219_intensity_t`
+    MAX7219_REGISTER_SCAN_LIMIT = 0x0B,       ///< Scan limit, number of scanned digits minus one
+    MAX7219_REGISTER_SHUTDOWN = 0x0C,         ///< Shutdown, 0 for shutdown mode and 1 for normal mode
+    MAX7219_REGISTER_DISPLAY_TEST = 0x0F      ///< Display test, 1 for test mode and 0 to leave test mode
+} max7219_register_t;
+
+/**
+ * @brief One register write of a register command script. See `led_driver_max7219_compile_script()`.
+ */
+typedef struct max7219_script_step {
+    uint8_t chain_id;                   ///< Device to write to, starting at 1 for the first device, or 0 for all devices
+    max7219_register_t reg;             ///< Register to write
+    uint8_t data;                       ///< Value to write
+} max7219_script_step_t;
+
+/**
+ * @brief Compiled register command script handle.
+ */
+typedef struct max7219_script* max7219_script_handle_t;
+
+
+
+/**
+ * @brief SPI bus ownership policy.
+ */
+typedef enum {
+    MAX7219_BUS_OWNERSHIP_PER_OPERATION = 0,    ///< Acquire the SPI bus for each operation and release it when the operation completes (default). Other devices on the SPI host can transmit between operations
+    MAX7219_BUS_OWNERSHIP_PERSISTENT = 1,       ///< Acquire the SPI bus during initialization and keep it until `led_driver_max7219_free()`. For chains which are the only device on their SPI host
+    MAX7219_BUS_OWNERSHIP_IDLE_RELEASE = 2      ///< Keep the SPI bus between back to back operations and release it once the chain has been idle for `bus_idle_release_ms`
+} max7219_bus_ownership_t;
+
 /**
  * @brief Configuration of the SPI bus for MAX7219 / MAX7221 device.
  */
@@ -178,6 +391,8 @@ typedef struct max7219_spi_config {
     int input_delay_ns;                 ///< Maximum data valid time of slave. The time required between SCLK and MISO
     int spics_io_num;                   ///< CS GPIO pin for this device, or `GPIO_NUM_NC` (-1) if not used
     int queue_size;                     ///< SPI transaction queue size. See 'spi_device_queue_trans()'
+    max7219_bus_ownership_t bus_ownership;  ///< SPI bus ownership policy, `MAX7219_BUS_OWNERSHIP_PER_OPERATION` by default
+    uint32_t bus_idle_release_ms;       ///< With `MAX7219_BUS_OWNERSHIP_IDLE_RELEASE`, idle time in milliseconds after which the SPI bus is released
 } max7219_spi_config_t;
 
 /**
@@ -187,19 +402,62 @@ typedef struct max7219_hw_config {
     uint8_t chain_length;               ///< Number of MAX7219 / MAX7221 connected (1 to 255). See "Cascading Drivers" in the  MAX7219 / MAX7221 datasheet
 } max7219_hw_config_t;
 
+/**
+ * @brief State of one MAX7219 / MAX7221 device applied by `led_driver_max7219_init()`.
+ */
+typedef struct max7219_device_state {
+    uint8_t scan_limit;                 ///< Number of digits to scan (1 to 8)
+    max7219_decode_mode_t decode;       ///< Decode mode
+    max7219_intensity_t intensity;      ///< Intensity
+    const uint8_t* digits;              ///< Codes of the first `scan_limit` digits, digit 1 first, or NULL to blank all digits. Only read during initialization
+    max7219_mode_t mode;                ///< Mode entered once the device is configured
+} max7219_device_state_t;
+
+/**
+ * @brief Initial state of the chain applied by `led_driver_max7219_init()`.
+ */
+typedef struct max7219_initial_state {
+    bool apply;                                 ///< Apply the initial state during initialization. When false (default), devices are left as they are
+    max7219_device_state_t chain;               ///< State of all devices when `devices` is NULL
+    const max7219_device_state_t* devices;      ///< Optional, one state per device, first device first (`chain_length` entries). Only read during initialization
+} max7219_initial_state_t;
+
 /**
  * @brief Configuration of MAX7219 / MAX7221 device.
  */
 typedef struct max7219_config {
     max7219_spi_config_t spi_cfg;       ///< SPI configuration for MAX7219 / MAX7221
     max7219_hw_config_t hw_config;      ///< MAX7219 / MAX7221 hardware configuration
+    max7219_initial_state_t initial_state;  ///< Optional, state of the chain once initialized
 } max7219_config_t;
 
 
 
+/**
+ * @brief Caller provided storage for a MAX7219 / MAX7221 driver context.
+ */
+typedef struct led_driver_max7219_context_storage {
+    uint32_t opaque[(LED_DRIVER_MAX7219_CONTEXT_SIZE + sizeof(uint32_t) - 1) / sizeof(uint32_t)];  ///< Opaque - Do not access
+} __attribute__((aligned(8))) led_driver_max7219_context_storage_t;
+
+/**
+ * @brief Caller provided storage for `led_driver_max7219_init_static()`.
+ */
+typedef struct max7219_static_buffers {
+    led_driver_max7219_context_storage_t* context;  ///< Storage for the driver context
+    uint8_t* dma_buffer;                            ///< DMA capable command buffer (`DMA_ATTR`) of at least `LED_DRIVER_MAX7219_DMA_BUFFER_SIZE(chain_length)` bytes. Unused, may be NULL, for chains of 1 or 2 devices or with `CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH`
+    size_t dma_buffer_size;                         ///< Size of `dma_buffer` in bytes
+    StaticSemaphore_t* mutex;                       ///< Storage for the driver mutex. Unused, may be NULL, with `CONFIG_MAX_7219_7221_SINGLE_OWNER`
+} max7219_static_buffers_t;
+
+
+
 /**
  * @brief Initialize the MAX7219 / MAX7221 driver.
  * 
+ * @note When `config->initial_state.apply` is true, devices are configured, their digits written and their mode set before this function
+ *       returns, under a single bus acquisition and in one chain transfer per register.
+ * 
  * @param[in]  config Pointer to a configuration structure for the MAX7219 / MAX7221 driver
  * @param[out] handle Pointer to a memory location which receives the handle to the MAX7219 / MAX7221 driver
  * 
@@ -210,6 +468,22 @@ typedef struct max7219_config {
  */
 esp_err_t led_driver_max7219_init(const max7219_config_t* config, led_driver_max7219_handle_t* handle);
 
+/**
+ * @brief Initialize the MAX7219 / MAX7221 driver in caller provided storage, without heap allocations.
+ * 
+ * @note All buffers must remain valid until `led_driver_max7219_free()` returns. With `CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH`,
+ *       the command buffer is part of the context which must then be DMA capable (`DMA_ATTR`).
+ * 
+ * @param[in]  config Pointer to a configuration structure for the MAX7219 / MAX7221 driver
+ * @param[in]  buffers Storage for the driver context, the DMA command buffer and the mutex
+ * @param[out] handle Pointer to a memory location which receives the handle to the MAX7219 / MAX7221 driver
+ * 
+ * @return
+ *      - ESP_OK: Successfully installed driver
+ *      - ESP_ERR_INVALID_ARG: Arguments are invalid, e.g. invalid clock source, missing or too small buffer ...
+ */
+esp_err_t led_driver_max7219_init_static(const max7219_config_t* config, const max7219_static_buffers_t* buffers, led_driver_max7219_handle_t* handle);
+
 /**
  * @brief Free the MAX7219 / MAX7221 driver.
  * 
@@ -354,6 +628,30 @@ esp_err_t led_driver_max7219_set_chain_intensity(led_driver_max7219_handle_t han
  */
 esp_err_t led_driver_max7219_set_intensity(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_intensity_t intensity);
 
+/**
+ * @brief Same as `led_driver_max7219_set_intensity()`, waiting at most `ticksToWait` for the driver to be available.
+ * 
+ * @note The wait only covers other operations on the same handle. The wait for the SPI bus is bounded only when the driver keeps the bus
+ *       (see `max7219_bus_ownership_t`), is attached to a bus coordinator or is the only device on its SPI host.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  chainId Index of the MAX7219 / MAX7221 device to configure starting at 1 for the first device
+ * @param[in]  intensity The duty cycle to set. See `max7219_intensity_t` for possible values
+ * @param[in]  ticksToWait Maximum time to wait for the driver, in ticks. 0 returns right away when the driver is busy
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_TIMEOUT: The driver was busy for `ticksToWait` - Nothing was sent
+ */
+esp_err_t led_driver_max7219_set_intensity_timeout(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_intensity_t intensity, TickType_t ticksToWait);
+
+/**
+ * @brief Same as `led_driver_max7219_set_intensity_timeout()` without waiting: returns `ESP_ERR_TIMEOUT` right away when the driver is busy.
+ */
+esp_err_t led_driver_max7219_try_set_intensity(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_intensity_t intensity);
+
 
 
 /**
@@ -409,6 +707,533 @@ esp_err_t led_driver_max7219_set_digit(led_driver_max7219_handle_t handle, uint8
 esp_err_t led_driver_max7219_set_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount);
 
 
+/**
+ * @brief Same as `led_driver_max7219_set_digit()` without argument validation.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver. Must be a valid, initialized handle
+ * @param[in]  chainId Index of the MAX7219 / MAX7221 device to configure starting at 1 for the first device. Must be valid for the chain
+ * @param[in]  digit The digit to set (1 to 8)
+ * @param[in]  digitCode The digit code to set
+ *
+ * @warning Arguments are not validated. Passing an invalid handle, chain ID or digit is undefined behavior.
+ *          Use in trusted inner loops only, with arguments checked once upfront or via `MAX7219_STATIC_CHECK_CHAIN_ID()`.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - Other: Error reported by the SPI driver
+ */
+esp_err_t led_driver_max7219_set_digit_unchecked(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode);
+
+/**
+ * @brief Same as `led_driver_max7219_set_digits()` without argument validation.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver. Must be a valid, initialized handle
+ * @param[in]  startChainId Index of the MAX7219 / MAX7221 device where codes should start being sent to
+ * @param[in]  startDigitId The digit to start sending codes from (1 to 8)
+ * @param[in]  digitCodes An array of digit codes to send
+ * @param[in]  digitCodesCount Number of digit codes in array 'digitCodes'. Must fit in the chain
+ *
+ * @warning Arguments are not validated. Passing an invalid handle, chain ID, digit or count is undefined behavior.
+ *          Use in trusted inner loops only, with arguments checked once upfront or via `MAX7219_STATIC_CHECK_DIGITS()`.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - Other: Error reported by the SPI driver
+ */
+esp_err_t led_driver_max7219_set_digits_unchecked(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount);
+
+/**
+ * @brief Same as `led_driver_max7219_set_digit()`, waiting at most `ticksToWait` for the driver to be available.
+ * 
+ * @note The wait only covers other operations on the same handle. The wait for the SPI bus is bounded only when the driver keeps the bus
+ *       (see `max7219_bus_ownership_t`), is attached to a bus coordinator or is the only device on its SPI host.
+ *       When priority classes are enabled and the driver stays busy, the digit is staged as a `MAX7219_PRIORITY_BACKGROUND` update
+ *       and sent when the operation in progress completes. See `led_driver_max7219_enable_priority_classes()`.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  chainId Index of the MAX7219 / MAX7221 device to configure starting at 1 for the first device
+ * @param[in]  digit The digit to set (1 to 8)
+ * @param[in]  digitCode The digit code to set
+ * @param[in]  ticksToWait Maximum time to wait for the driver, in ticks. 0 returns right away when the driver is busy
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_TIMEOUT: The driver was busy for `ticksToWait` - Nothing was sent or staged
+ *      - ESP_ERR_NOT_FINISHED: The driver was busy for `ticksToWait` - The digit is staged and will be sent later
+ */
+esp_err_t led_driver_max7219_set_digit_timeout(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode, TickType_t ticksToWait);
+
+/**
+ * @brief Same as `led_driver_max7219_set_digit_timeout()` without waiting: returns `ESP_ERR_TIMEOUT` or `ESP_ERR_NOT_FINISHED` right away when the driver is busy.
+ */
+esp_err_t led_driver_max7219_try_set_digit(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode);
+
+/**
+ * @brief Same as `led_driver_max7219_set_digits()`, waiting at most `ticksToWait` for the driver to be available.
+ * 
+ * @note The wait only covers other operations on the same handle. The wait for the SPI bus is bounded only when the driver keeps the bus
+ *       (see `max7219_bus_ownership_t`), is attached to a bus coordinator or is the only device on its SPI host.
+ *       When priority classes are enabled and the driver stays busy, the digits are staged as `MAX7219_PRIORITY_BACKGROUND` updates
+ *       and sent when the operation in progress completes. See `led_driver_max7219_enable_priority_classes()`.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  startChainId Index of the MAX7219 / MAX7221 device where codes should start being sent to
+ * @param[in]  startDigitId The digit to start sending codes from (1 to 8)
+ * @param[in]  digitCodes An array of digit codes to send
+ * @param[in]  digitCodesCount Number of digit codes in array 'digitCodes'
+ * @param[in]  ticksToWait Maximum time to wait for the driver, in ticks. 0 returns right away when the driver is busy
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_TIMEOUT: The driver was busy for `ticksToWait` - Nothing was sent or staged
+ *      - ESP_ERR_NOT_FINISHED: The driver was busy for `ticksToWait` - The digits are staged and will be sent later
+ */
+esp_err_t led_driver_max7219_set_digits_timeout(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, TickType_t ticksToWait);
+
+/**
+ * @brief Same as `led_driver_max7219_set_digits_timeout()` without waiting: returns `ESP_ERR_TIMEOUT` or `ESP_ERR_NOT_FINISHED` right away when the driver is busy.
+ */
+esp_err_t led_driver_max7219_try_set_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount);
+
+/**
+ * @brief Send the digit codes flagged in `changedDigits` to MAX7219 / MAX7221 devices on the chain, starting at the given device and digit.
+ * 
+ * @note Digit codes are laid out as in `led_driver_max7219_set_digits()`. Only flagged codes are sent and each chain transfer carries one
+ *       flagged code per device, so updating one digit on each of N devices costs one chain transfer instead of N.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  startChainId Index of the MAX7219 / MAX7221 device where codes should start being sent to
+ * @param[in]  startDigitId The digit to start sending codes from (1 to 8)
+ * @param[in]  digitCodes An array of digit codes
+ * @param[in]  digitCodesCount Number of digit codes in array 'digitCodes'
+ * @param[in]  changedDigits Bit set of the codes to send - Bit `i % 8` of `changedDigits[i / 8]` is set to send `digitCodes[i]`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_set_changed_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, const uint8_t changedDigits[]);
+
+/**
+ * @brief Same as `led_driver_max7219_set_changed_digits()`, waiting at most `ticksToWait` for the driver to be available.
+ *
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  startChainId Index of the MAX7219 / MAX7221 device where codes should start being sent to
+ * @param[in]  startDigitId The digit to start sending codes from (1 to 8)
+ * @param[in]  digitCodes An array of digit codes
+ * @param[in]  digitCodesCount Number of digit codes in array 'digitCodes'
+ * @param[in]  changedDigits Bit set of the codes to send - Bit `i % 8` of `changedDigits[i / 8]` is set to send `digitCodes[i]`
+ * @param[in]  ticksToWait Maximum time to wait for the driver, in ticks. 0 returns right away when the driver is busy
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_TIMEOUT: The driver was busy for `ticksToWait` - Nothing was sent
+ */
+esp_err_t led_driver_max7219_set_changed_digits_timeout(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, const uint8_t changedDigits[], TickType_t ticksToWait);
+
+/**
+ * @brief Same as `led_driver_max7219_set_changed_digits_timeout()` without waiting: returns `ESP_ERR_TIMEOUT` right away when the driver is busy.
+ */
+esp_err_t led_driver_max7219_try_set_changed_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, const uint8_t changedDigits[]);
+
+
+
+
+/**
+ * @brief Enable front / back frame buffers on the chain.
+ * 
+ * @note A frame holds `chain_length * MAX7219_MAX_DIGIT` digit codes. The code for digit `digit` of device `chainId` is at `MAX7219_FRAME_INDEX(chainId, digit)`.
+ *       A single producer task renders into the back buffer without locking, publishes it with `led_driver_max7219_swap_buffers()` and
+ *       any task sends the last published frame with `led_driver_max7219_flush()`. The back buffer is initially all zeros.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[out] backBuffer Pointer to a memory location which receives the back buffer
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state or frame buffers are already enabled
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_enable_frame_buffers(led_driver_max7219_handle_t handle, uint8_t** backBuffer);
+
+/**
+ * @brief Publish the back buffer as the next frame to send.
+ * 
+ * @note Only pointers are exchanged so publishing is constant time. A published frame not yet flushed is replaced.
+ *       On return, `backBuffer` receives the new back buffer which holds a copy of the frame just published.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[out] backBuffer Pointer to a memory location which receives the new back buffer. The previous back buffer must not be accessed anymore
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: Frame buffers are not enabled
+ */
+esp_err_t led_driver_max7219_swap_buffers(led_driver_max7219_handle_t handle, uint8_t** backBuffer);
+
+/**
+ * @brief Send the last published frame to the chain, if any.
+ * 
+ * @note Only digits which differ from the previously flushed frame are sent, packing one digit per device into each chain transfer.
+ *       Digits written with `led_driver_max7219_set_digit()` / `led_driver_max7219_set_digits()` ... cause the next flush to send the whole frame.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ *
+ * @return
+ *      - ESP_OK: Success, including when no frame was published since the last flush
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state or frame buffers are not enabled
+ */
+esp_err_t led_driver_max7219_flush(led_driver_max7219_handle_t handle);
+
+
+
+/**
+ * @brief Enable priority classes for digit updates. See `led_driver_max7219_set_digit_with_priority()`.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state or priority classes are already enabled
+ *      - ESP_ERR_NOT_SUPPORTED: Not available with `CONFIG_MAX_7219_7221_SINGLE_OWNER`
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_enable_priority_classes(led_driver_max7219_handle_t handle);
+
+/**
+ * @brief Set the given digit code on a MAX7219 / MAX7221 device on the chain with the given priority.
+ * 
+ * @note Urgent and background digits are staged and sent by whichever task currently uses the driver, or by the caller if the driver is idle.
+ *       When another task is sending a multi transfer operation (`led_driver_max7219_set_digits()`, `led_driver_max7219_flush()` ...),
+ *       urgent digits are sent after the transfer in progress and the function returns without waiting. Errors sending staged digits are
+ *       reported to the task sending them.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  chainId Index of the MAX7219 / MAX7221 device to configure starting at 1 for the first device
+ * @param[in]  digit The digit to set (1 to 8)
+ * @param[in]  digitCode The digit code to set
+ * @param[in]  priority Priority class of the update. See `max7219_priority_t`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state or priority classes are not enabled
+ */
+esp_err_t led_driver_max7219_set_digit_with_priority(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode, max7219_priority_t priority);
+
+/**
+ * @brief Get the worst case update latency per priority class.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[out] latency Pointer to a memory location which receives latency statistics
+ * @param[in]  reset Whether to reset statistics after reading them
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: Priority classes are not enabled
+ */
+esp_err_t led_driver_max7219_get_priority_latency(led_driver_max7219_handle_t handle, max7219_priority_latency_t* latency, bool reset);
+
+
+
+/**
+ * @brief Set or disable the write combining window.
+ * 
+ * @note While a window is set, `led_driver_max7219_set_chain_digit()`, `led_driver_max7219_set_digit()`, `led_driver_max7219_set_digits()` and their
+ *       `_unchecked` variants return as soon as the digits are staged. The first staged digit opens the window. Digits written again before the
+ *       window closes replace the staged value. When the window closes, all staged digits are sent as one coalesced update, one digit per device
+ *       per chain transfer. Staged digits are also sent ahead of any other driver operation so operations are applied in order.
+ *       The window closes on the esp_timer task, which never waits for the driver mutex: while the driver is busy, the update is retried one window later.
+ *       Unless the SPI bus is kept between operations or shared through a bus coordinator, the esp_timer task still waits for other devices on the
+ *       same SPI host to release the bus.
+ *       If the coalesced update fails to send, the next write staging digits returns the error.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  windowMs Duration of the window in milliseconds, at most `UINT32_MAX / 1000`, or 0 to disable write combining. Staged digits are sent before this function returns when disabling
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_NOT_SUPPORTED: A window was requested with `CONFIG_MAX_7219_7221_SINGLE_OWNER`
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_set_write_combining_window(led_driver_max7219_handle_t handle, uint32_t windowMs);
+
+
+
+/**
+ * @brief Set or disable the power policy.
+ * 
+ * @note The policy only manages devices in normal mode. Modes sent before the policy is first set, including the initial state, are not tracked:
+ *       every device then counts as in normal mode until its mode is set with `led_driver_max7219_set_chain_mode()` / `led_driver_max7219_set_mode()`.
+ *       A device shut down by the policy is still in normal mode from the application point of view and is woken up automatically:
+ *        * A blank device wakes up as soon as one of its digits is lit,
+ *        * After an idle shutdown, all devices wake up on the next operation, except blank devices if `shutdown_blank_devices` is set.
+ *       Digits are considered lit until they are written. Setting a mode explicitly always overrides the policy.
+ *       The idle shutdown is sent from the esp_timer task and skipped while the driver is busy. It may still wait for the SPI bus when other devices
+ *       share the SPI host, unless the bus is kept between operations or shared through a bus coordinator.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  policy The power policy to apply, or NULL to disable. Devices shut down by the policy are woken up when the policy is disabled
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_NOT_SUPPORTED: An idle timeout was requested with `CONFIG_MAX_7219_7221_SINGLE_OWNER`
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_set_power_policy(led_driver_max7219_handle_t handle, const max7219_power_policy_t* policy);
+
+
+
+/**
+ * @brief Create a coordinator sharing one SPI host between several chains.
+ * 
+ * @note Chains attached to a coordinator no longer take exclusive access of the SPI bus for each operation. Their chain transfers are
+ *       copied to a per chain ring and the coordinator task queues them to the SPI host, one transfer per chain in turn, so several chains
+ *       refreshing at the same time share the bus fairly and the bus stays busy while any chain has transfers waiting.
+ * 
+ * @param[in]  config Pointer to a coordinator configuration structure
+ * @param[out] coordinator Pointer to a memory location which receives the handle to the coordinator
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_bus_coordinator_create(const max7219_bus_coordinator_config_t* config, max7219_bus_coordinator_handle_t* coordinator);
+
+/**
+ * @brief Delete a shared SPI bus coordinator.
+ * 
+ * @param[in]  coordinator Handle to the coordinator. All chains must have been detached
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: Chains are still attached to the coordinator
+ */
+esp_err_t led_driver_max7219_bus_coordinator_delete(max7219_bus_coordinator_handle_t coordinator);
+
+/**
+ * @brief Send all transfers of a chain through a shared SPI bus coordinator.
+ * 
+ * @note Once attached, functions sending to the chain return as soon as their chain transfers are handed to the coordinator. A transfer
+ *       error is returned by the next function sending to the chain or by `led_driver_max7219_detach_bus_coordinator()`.
+ *       The coordinator only serves SPI devices of one host: attach chains created with the same `spi_cfg.host_id`.
+ *       `spi_cfg.queue_size` limits how many transfers of this chain are queued to the SPI host at once.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  coordinator Handle to the coordinator
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state or already attached to a coordinator
+ *      - ESP_ERR_NO_MEM: Insufficient memory or the coordinator already serves `max_chains` chains
+ */
+esp_err_t led_driver_max7219_attach_bus_coordinator(led_driver_max7219_handle_t handle, max7219_bus_coordinator_handle_t coordinator);
+
+/**
+ * @brief Wait for outstanding transfers of a chain and stop sending through its bus coordinator.
+ * 
+ * @note `led_driver_max7219_free()` detaches the chain automatically. Detaching a chain which is not attached does nothing.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - Any error of an outstanding transfer
+ */
+esp_err_t led_driver_max7219_detach_bus_coordinator(led_driver_max7219_handle_t handle);
+
+
+
+/**
+ * @brief Start tracing the latency of each stage of every driver operation.
+ * 
+ * @note Requires `CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING`. Each stage is timestamped with `esp_timer_get_time()` and recorded in fixed bucket histograms per operation.
+ *       Digits staged with `led_driver_max7219_set_digit_with_priority()` count towards the operation which sends them.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ *      - ESP_ERR_NOT_SUPPORTED: `CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING` is not set
+ */
+esp_err_t led_driver_max7219_enable_latency_tracing(led_driver_max7219_handle_t handle);
+
+/**
+ * @brief Get latency histograms recorded since tracing was enabled or last reset.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[out] trace Pointer to a memory location which receives the histograms
+ * @param[in]  reset Whether to reset histograms after reading them
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: Latency tracing is not enabled
+ *      - ESP_ERR_NOT_SUPPORTED: `CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING` is not set
+ */
+esp_err_t led_driver_max7219_get_latency_trace(led_driver_max7219_handle_t handle, max7219_latency_trace_t* trace, bool reset);
+
+/**
+ * @brief Estimate a latency percentile from a histogram.
+ * 
+ * @param[in]  histogram Pointer to a histogram
+ * @param[in]  percentile Percentile to estimate (0 to 100)
+ *
+ * @return Upper bound, in microseconds, of the bucket holding the requested percentile, never more than `max_us`. 0 if the histogram is empty
+ */
+uint32_t led_driver_max7219_latency_percentile(const max7219_latency_histogram_t* histogram, uint8_t percentile);
+
+/**
+ * @brief Print sample count, p50, p99 and maximum latency of every stage of every operation which was traced at least once.
+ * 
+ * @param[in]  trace Pointer to latency histograms. See `led_driver_max7219_get_latency_trace()`
+ */
+void led_driver_max7219_print_latency_trace(const max7219_latency_trace_t* trace);
+
+/**
+ * @brief Register the `max7219_latency [reset]` console command printing latency histograms of a driver.
+ * 
+ * @note Only one driver can be inspected from the console. Registering again replaces the driver the command inspects.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver, with latency tracing enabled
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: `CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING` is not set
+ *      - Errors returned by `esp_console_cmd_register()`
+ */
+esp_err_t led_driver_max7219_register_latency_console_command(led_driver_max7219_handle_t handle);
+
+
+
+/**
+ * @brief Start recording every chain transfer sent to the chain.
+ * 
+ * @note Requires `CONFIG_MAX_7219_7221_ENABLE_CAPTURE`. Each transfer is recorded with its start time and duration in a ring of `recordCount` records.
+ *       When the ring is full, the oldest record is overwritten. Each record takes `sizeof(max7219_capture_record_t) + 2 * chain_length` bytes.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  recordCount Number of records the ring holds
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state or capture is already enabled
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ *      - ESP_ERR_NOT_SUPPORTED: `CONFIG_MAX_7219_7221_ENABLE_CAPTURE` is not set
+ */
+esp_err_t led_driver_max7219_enable_capture(led_driver_max7219_handle_t handle, uint16_t recordCount);
+
+/**
+ * @brief Move the oldest captured transfers to a buffer as one capture chunk. See `max7219_7221_capture.h` for the format.
+ * 
+ * @note Records copied to `buffer` are removed from the ring. Call until `*length` is `sizeof(max7219_capture_header_t)` to drain the ring.
+ *       Chunks can be concatenated, e.g. written one after the other to a file, and replayed with `tools/max7219_replay`.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[out] buffer Buffer which receives a chunk header followed by as many records as fit
+ * @param[in]  bufferSize Size of `buffer` in bytes
+ * @param[out] length Pointer to a memory location which receives the number of bytes written to `buffer`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_SIZE: `buffer` cannot hold one record
+ *      - ESP_ERR_INVALID_STATE: Capture is not enabled
+ *      - ESP_ERR_NOT_SUPPORTED: `CONFIG_MAX_7219_7221_ENABLE_CAPTURE` is not set
+ */
+esp_err_t led_driver_max7219_read_capture(led_driver_max7219_handle_t handle, uint8_t* buffer, size_t bufferSize, size_t* length);
+
+
+
+/**
+ * @brief Compile a sequence of register writes into chain transfers ready to be sent, for playback with `led_driver_max7219_play_script()`.
+ * 
+ * @note Steps are packed into as few chain transfers as possible: a chain transfer carries one command per device, so writes to different
+ *       devices share transfers. Writes to the same device, and writes to all devices (`chain_id` 0), keep their relative order.
+ *       Transfers are stored in DMA capable memory and are never encoded again. `steps` can be freed once this function returns.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver the script is played on
+ * @param[in]  steps Register writes, in order
+ * @param[in]  stepCount Number of steps in `steps`
+ * @param[out] script Pointer to a memory location which receives a handle to the compiled script
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_compile_script(led_driver_max7219_handle_t handle, const max7219_script_step_t steps[], uint16_t stepCount, max7219_script_handle_t* script);
+
+/**
+ * @brief Send all chain transfers of a compiled script as one batch, queued back to back to the SPI host.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver the script was compiled for
+ * @param[in]  script Compiled script
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument, including a script compiled for another driver
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_play_script(led_driver_max7219_handle_t handle, max7219_script_handle_t script);
+
+/**
+ * @brief Release a compiled script.
+ * 
+ * @param[in]  script Compiled script
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_delete_script(max7219_script_handle_t script);
+
+/**
+ * @brief Send pre-encoded chain transfers, as produced by the `max7219_assets` tool, without any encoding.
+ *
+ * @note A wire frame is one chain transfer: `chain_length` commands of two bytes (register address then data), in the order they are
+ *       clocked out - The command for the last device of the chain comes first. Frames can live in flash and are copied to the driver
+ *       command buffer before each transfer.
+ * 
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  frames Wire frames to send, in order. Each frame is `chain_length` * 2 bytes
+ * @param[in]  frameCount Number of frames in `frames`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_send_wire_frames(led_driver_max7219_handle_t handle, const uint8_t* const frames[], uint16_t frameCount);
+
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,394 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error "max7219_7221.hpp requires C++17 or later"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+#include "max7219_7221.h"
+
+
+//
+// Header only C++ wrapper over the MAX7219 / MAX7221 driver. The chain length and what digit registers drive are template parameters so:
+//  * Chain and digit indexes given as template arguments are checked at compile time and call the `_unchecked` functions of the driver,
+//  * Characters are encoded with constexpr fonts - Constant text is encoded at compile time,
+//  * Frames are `std::array` of digit codes, in the layout of `MAX7219_FRAME_INDEX()`, written in place and sent in one call.
+// Functions return `esp_err_t` like the C API since ESP-IDF builds C++ without exceptions by default.
+//
+
+namespace max7219 {
+
+/**
+ * @brief What the digit registers of the chain drive. Selects the decode mode applied by `Max7219Chain::init()` and the font used to encode characters.
+ */
+enum class Layout {
+    CodeB,              ///< Seven-segment digits in Code B decode mode. Digit codes are `max7219_code_b_font_t` values
+    SevenSegment,       ///< Seven-segment digits in no decode mode. Digit codes are combinations of `max7219_segment_t` values
+    Matrix              ///< LED matrix modules in no decode mode. Digit codes are rows of 8 LEDs and characters cannot be encoded
+};
+
+constexpr uint8_t DecimalPoint = MAX7219_SEGMENT_DP;   ///< Decimal point - Combine with any seven-segment or Code B digit code
+
+
+namespace detail {
+    // Not constexpr on purpose - Reaching this function during constant evaluation fails the build on an invalid character
+    inline void invalid_character() {}
+}
+
+/**
+ * @brief Seven-segment digit code of segment letters 'a' to 'g' and '.' (decimal point), in any order. `segments("bc")` is digit 1.
+ *
+ * @note Fails to build on any other character when evaluated at compile time.
+ */
+constexpr uint8_t segments(const char* letters) {
+    uint8_t code = 0;
+    for (; *letters != '\0'; letters++) {
+        switch (*letters) {
+            case 'a': code |= MAX7219_SEGMENT_A; break;
+            case 'b': code |= MAX7219_SEGMENT_B; break;
+            case 'c': code |= MAX7219_SEGMENT_C; break;
+            case 'd': code |= MAX7219_SEGMENT_D; break;
+            case 'e': code |= MAX7219_SEGMENT_E; break;
+            case 'f': code |= MAX7219_SEGMENT_F; break;
+            case 'g': code |= MAX7219_SEGMENT_G; break;
+            case '.': code |= MAX7219_SEGMENT_DP; break;
+            default: detail::invalid_character(); break;
+        }
+    }
+    return code;
+}
+
+namespace fonts {
+    /**
+     * @brief Seven-segment digit code of a character in no decode mode: '0' to '9', the letters of `max7219_direct_addressing_font_t`, '-' and ' '.
+     *
+     * @note Fails to build on any other character when evaluated at compile time. Returns blank at runtime.
+     */
+    constexpr uint8_t sevenSegment(char character) {
+        switch (character) {
+            case '0': return MAX7219_DIRECT_ADDRESSING_0;
+            case '1': return MAX7219_DIRECT_ADDRESSING_1;
+            case '2': return MAX7219_DIRECT_ADDRESSING_2;
+            case '3': return MAX7219_DIRECT_ADDRESSING_3;
+            case '4': return MAX7219_DIRECT_ADDRESSING_4;
+            case '5': return MAX7219_DIRECT_ADDRESSING_5;
+            case '6': return MAX7219_DIRECT_ADDRESSING_6;
+            case '7': return MAX7219_DIRECT_ADDRESSING_7;
+            case '8': return MAX7219_DIRECT_ADDRESSING_8;
+            case '9': return MAX7219_DIRECT_ADDRESSING_9;
+            case 'A': return MAX7219_DIRECT_ADDRESSING_A;
+            case 'C': return MAX7219_DIRECT_ADDRESSING_C;
+            case 'E': return MAX7219_DIRECT_ADDRESSING_E;
+            case 'F': return MAX7219_DIRECT_ADDRESSING_F;
+            case 'H': return MAX7219_DIRECT_ADDRESSING_H;
+            case 'J': return MAX7219_DIRECT_ADDRESSING_J;
+            case 'L': return MAX7219_DIRECT_ADDRESSING_L;
+            case 'P': return MAX7219_DIRECT_ADDRESSING_P;
+            case 'U': return MAX7219_DIRECT_ADDRESSING_U;
+            case 'b': return MAX7219_DIRECT_ADDRESSING_b;
+            case 'd': return MAX7219_DIRECT_ADDRESSING_d;
+            case 'h': return MAX7219_DIRECT_ADDRESSING_h;
+            case 'o': return MAX7219_DIRECT_ADDRESSING_o;
+            case 'r': return MAX7219_DIRECT_ADDRESSING_r;
+            case 't': return MAX7219_DIRECT_ADDRESSING_t;
+            case 'u': return MAX7219_DIRECT_ADDRESSING_u;
+            case 'y': return MAX7219_DIRECT_ADDRESSING_y;
+            case '-': return MAX7219_DIRECT_ADDRESSING_MINUS;
+            case ' ': return MAX7219_DIRECT_ADDRESSING_BLANK;
+            default:
+                detail::invalid_character();
+                return MAX7219_DIRECT_ADDRESSING_BLANK;
+        }
+    }
+
+    /**
+     * @brief Code B digit code of a character: '0' to '9', '-', 'E', 'H', 'L', 'P' and ' '.
+     *
+     * @note Fails to build on any other character when evaluated at compile time. Returns blank at runtime.
+     */
+    constexpr uint8_t codeB(char character) {
+        if ((character >= '0') && (character <= '9')) {
+            return static_cast<uint8_t>(MAX7219_CODE_B_0 + (character - '0'));
+        }
+
+        switch (character) {
+            case '-': return MAX7219_CODE_B_MINUS;
+            case 'E': return MAX7219_CODE_B_E;
+            case 'H': return MAX7219_CODE_B_H;
+            case 'L': return MAX7219_CODE_B_L;
+            case 'P': return MAX7219_CODE_B_P;
+            case ' ': return MAX7219_CODE_B_BLANK;
+            default:
+                detail::invalid_character();
+                return MAX7219_CODE_B_BLANK;
+        }
+    }
+}
+
+/**
+ * @brief Decode mode, blank code and font of each `Layout`.
+ */
+template <Layout L>
+struct LayoutTraits;
+
+template <>
+struct LayoutTraits<Layout::CodeB> {
+    static constexpr max7219_decode_mode_t decode = MAX7219_CODE_B_DECODE_ALL;
+    static constexpr uint8_t blank = MAX7219_CODE_B_BLANK;
+    static constexpr uint8_t encode(char character) { return fonts::codeB(character); }
+};
+
+template <>
+struct LayoutTraits<Layout::SevenSegment> {
+    static constexpr max7219_decode_mode_t decode = MAX7219_CODE_B_DECODE_NONE;
+    static constexpr uint8_t blank = MAX7219_DIRECT_ADDRESSING_BLANK;
+    static constexpr uint8_t encode(char character) { return fonts::sevenSegment(character); }
+};
+
+template <>
+struct LayoutTraits<Layout::Matrix> {
+    static constexpr max7219_decode_mode_t decode = MAX7219_CODE_B_DECODE_NONE;
+    static constexpr uint8_t blank = 0;
+};
+
+
+/**
+ * @brief MAX7219 / MAX7221 chain of `ChainLength` devices, owning a `led_driver_max7219_handle_t` freed on destruction.
+ */
+template <uint8_t ChainLength, Layout L = Layout::SevenSegment>
+class Max7219Chain {
+    static_assert(ChainLength >= 1, "ChainLength must be >= 1");
+#ifdef MAX7219_FIXED_CHAIN_LENGTH
+    static_assert(ChainLength == MAX7219_FIXED_CHAIN_LENGTH, "ChainLength must match CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH");
+#endif
+
+public:
+    static constexpr uint8_t Length = ChainLength;                                  ///< Number of devices on the chain
+    static constexpr uint16_t DigitCount = ChainLength * MAX7219_MAX_DIGIT;         ///< Number of digit registers on the chain
+    static constexpr uint8_t Blank = LayoutTraits<L>::blank;                        ///< Digit code of a blank digit
+
+    using Frame = std::array<uint8_t, DigitCount>;  ///< One code per digit register, laid out as `MAX7219_FRAME_INDEX()`: digits 1 to 8 of device 1 first
+
+
+    Max7219Chain() = default;
+
+    ~Max7219Chain() {
+        reset();
+    }
+
+    Max7219Chain(const Max7219Chain&) = delete;
+    Max7219Chain& operator=(const Max7219Chain&) = delete;
+
+    Max7219Chain(Max7219Chain&& other) noexcept : handle_(other.release()) {}
+
+    Max7219Chain& operator=(Max7219Chain&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = other.release();
+        }
+        return *this;
+    }
+
+
+    /**
+     * @brief Initialize the driver: all devices scan 8 digits in the decode mode of `L`, blank, at the given intensity and in normal mode.
+     *
+     * @param[in]  spiConfig SPI configuration. See `max7219_spi_config_t`
+     * @param[in]  intensity Intensity of all devices
+     *
+     * @return See `led_driver_max7219_init()`
+     */
+    esp_err_t init(const max7219_spi_config_t& spiConfig, max7219_intensity_t intensity = MAX7219_INTENSITY_DUTY_CYCLE_STEP_8) {
+        reset();
+
+        max7219_config_t config = {};
+        config.spi_cfg = spiConfig;
+        config.hw_config.chain_length = ChainLength;
+        config.initial_state.apply = true;
+        config.initial_state.chain.scan_limit = MAX7219_MAX_DIGIT;
+        config.initial_state.chain.decode = LayoutTraits<L>::decode;
+        config.initial_state.chain.intensity = intensity;
+        config.initial_state.chain.digits = nullptr;
+        config.initial_state.chain.mode = MAX7219_NORMAL_MODE;
+        return led_driver_max7219_init(&config, &handle_);
+    }
+
+    /**
+     * @brief Free the driver, if initialized. See `led_driver_max7219_free()`.
+     */
+    void reset() {
+        if (handle_ != nullptr) {
+            led_driver_max7219_free(handle_);
+            handle_ = nullptr;
+        }
+    }
+
+    /**
+     * @brief Give up ownership of the handle without freeing it.
+     */
+    led_driver_max7219_handle_t release() {
+        led_driver_max7219_handle_t handle = handle_;
+        handle_ = nullptr;
+        return handle;
+    }
+
+    led_driver_max7219_handle_t handle() const { return handle_; }      ///< Handle to the driver, for C functions
+    explicit operator bool() const { return handle_ != nullptr; }       ///< True once initialized
+
+
+    /**
+     * @brief Index of digit `Digit` of device `ChainId` in a `Frame`, checked at compile time.
+     */
+    template <uint8_t ChainId, uint8_t Digit>
+    static constexpr std::size_t index() {
+        static_assert((ChainId >= 1) && (ChainId <= ChainLength), "Invalid chain ID");
+        static_assert((Digit >= MAX7219_MIN_DIGIT) && (Digit <= MAX7219_MAX_DIGIT), "Invalid digit");
+        return MAX7219_FRAME_INDEX(ChainId, Digit);
+    }
+
+    /**
+     * @brief Digit code of a character in the font of `L`. See `fonts::codeB()` and `fonts::sevenSegment()`.
+     */
+    static constexpr uint8_t encode(char character) {
+        static_assert(L != Layout::Matrix, "Characters cannot be encoded on LED matrix modules");
+        return LayoutTraits<L>::encode(character);
+    }
+
+    /**
+     * @brief Digit codes of `text`, one character per digit. Encoded at compile time when `text` is a constant.
+     */
+    template <std::size_t N>
+    static constexpr std::array<uint8_t, N - 1> encode(const char (&text)[N]) {
+        std::array<uint8_t, N - 1> codes = {};
+        for (std::size_t index = 0; index < N - 1; index++) {
+            codes[index] = encode(text[index]);
+        }
+        return codes;
+    }
+
+    /**
+     * @brief A frame with every digit blank.
+     */
+    static constexpr Frame blankFrame() {
+        Frame frame = {};
+        for (uint8_t& code : frame) {
+            code = Blank;
+        }
+        return frame;
+    }
+
+    /**
+     * @brief Write `text` in `frame`, one character per digit, from digit `StartDigit` of device `StartChainId`. Checked at compile time.
+     */
+    template <uint8_t StartChainId, uint8_t StartDigit, std::size_t N>
+    static constexpr void print(Frame& frame, const char (&text)[N]) {
+        constexpr std::size_t start = index<StartChainId, StartDigit>();
+        static_assert(start + (N - 1) <= DigitCount, "Text does not fit in the chain");
+        for (std::size_t offset = 0; offset < N - 1; offset++) {
+            frame[start + offset] = encode(text[offset]);
+        }
+    }
+
+
+    /**
+     * @brief Set one digit. Indexes are checked at compile time and the digit is sent without runtime validation.
+     */
+    template <uint8_t ChainId, uint8_t Digit>
+    esp_err_t setDigit(uint8_t digitCode) {
+        index<ChainId, Digit>();
+        return led_driver_max7219_set_digit_unchecked(handle_, ChainId, Digit, digitCode);
+    }
+
+    /**
+     * @brief Set digits from digit `StartDigit` of device `StartChainId`. Indexes and length are checked at compile time.
+     */
+    template <uint8_t StartChainId, uint8_t StartDigit, std::size_t N>
+    esp_err_t setDigits(const std::array<uint8_t, N>& digitCodes) {
+        static_assert(N > 0, "No digit code");
+        static_assert(index<StartChainId, StartDigit>() + N <= DigitCount, "Digit codes do not fit in the chain");
+        return led_driver_max7219_set_digits_unchecked(handle_, StartChainId, StartDigit, digitCodes.data(), static_cast<uint16_t>(N));
+    }
+
+    /**
+     * @brief Send a whole frame in one call.
+     */
+    esp_err_t show(const Frame& frame) {
+        return led_driver_max7219_set_digits_unchecked(handle_, 1, MAX7219_MIN_DIGIT, frame.data(), DigitCount);
+    }
+
+#if __cplusplus >= 202002L
+    /**
+     * @brief Set digits from digit `StartDigit` of device `StartChainId`. Indexes, and the length of fixed extent spans, are checked at compile time.
+     */
+    template <uint8_t StartChainId, uint8_t StartDigit, std::size_t Extent>
+    esp_err_t setDigits(std::span<const uint8_t, Extent> digitCodes) {
+        constexpr std::size_t start = index<StartChainId, StartDigit>();
+        if constexpr (Extent != std::dynamic_extent) {
+            static_assert((Extent > 0) && (start + Extent <= DigitCount), "Digit codes do not fit in the chain");
+            return led_driver_max7219_set_digits_unchecked(handle_, StartChainId, StartDigit, digitCodes.data(), static_cast<uint16_t>(Extent));
+        } else {
+            if ((digitCodes.size() == 0) || (start + digitCodes.size() > DigitCount)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            return led_driver_max7219_set_digits_unchecked(handle_, StartChainId, StartDigit, digitCodes.data(), static_cast<uint16_t>(digitCodes.size()));
+        }
+    }
+
+    /**
+     * @brief Set digits from a runtime position. Validated by the driver.
+     */
+    esp_err_t setDigits(uint8_t startChainId, uint8_t startDigit, std::span<const uint8_t> digitCodes) {
+        if (digitCodes.size() > DigitCount) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        return led_driver_max7219_set_digits(handle_, startChainId, startDigit, digitCodes.data(), static_cast<uint16_t>(digitCodes.size()));
+    }
+#endif
+
+    /**
+     * @brief Set one digit at a runtime position. Validated by the driver.
+     */
+    esp_err_t setDigit(uint8_t chainId, uint8_t digit, uint8_t digitCode) {
+        return led_driver_max7219_set_digit(handle_, chainId, digit, digitCode);
+    }
+
+
+    /**
+     * @brief Set intensity of device `ChainId`, checked at compile time.
+     */
+    template <uint8_t ChainId>
+    esp_err_t setIntensity(max7219_intensity_t intensity) {
+        static_assert((ChainId >= 1) && (ChainId <= ChainLength), "Invalid chain ID");
+        return led_driver_max7219_set_intensity(handle_, ChainId, intensity);
+    }
+
+    /**
+     * @brief Set intensity of all devices.
+     */
+    esp_err_t setIntensity(max7219_intensity_t intensity) {
+        return led_driver_max7219_set_chain_intensity(handle_, intensity);
+    }
+
+    /**
+     * @brief Set mode of all devices.
+     */
+    esp_err_t setMode(max7219_mode_t mode) {
+        return led_driver_max7219_set_chain_mode(handle_, mode);
+    }
+
+private:
+    led_driver_max7219_handle_t handle_ = nullptr;
+};
+
+}
@@ -0,0 +1,145 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#include "max7219_7221.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Animations are sequences of frames of digit codes, stored compressed - Typically in flash - and decoded one frame at a time.
+// A frame holds one code per digit register, in the order of `led_driver_max7219_set_digits()`: from a start digit of a start device,
+// continuing on digit 1 of the next device. Frames work the same for seven-segment digits and for LED matrix rows.
+//
+// Format, all values little endian:
+//
+//  Header (10 bytes)
+//      uint8_t  magic[2]       'M', '7'
+//      uint8_t  version        MAX7219_ANIMATION_VERSION
+//      uint8_t  reserved       0
+//      uint16_t digit_count    Digit codes per frame (1 to 2040)
+//      uint16_t frame_count    Number of frames (>= 1)
+//      uint16_t frame_ms       Suggested time between frames, in milliseconds
+//
+//  Frames, back to back, the first frame must be a key frame
+//      uint8_t  type           MAX7219_ANIMATION_KEY_FRAME or MAX7219_ANIMATION_DELTA_FRAME
+//      Run length tokens, until `digit_count` bytes are produced
+//          0x00 - 0x7F         Literal - (token + 1) bytes follow
+//          0x80 - 0xFF         Run - The next byte repeats ((token & 0x7F) + 1) times
+//
+//  Key frames produce digit codes. Delta frames produce the XOR of each digit code with the previous frame, so unchanged digits are runs of 0.
+//
+
+#define MAX7219_ANIMATION_VERSION 1             ///< Version of the animation format
+#define MAX7219_ANIMATION_HEADER_SIZE 10        ///< Size of the animation header, in bytes
+#define MAX7219_ANIMATION_KEY_FRAME 0x00        ///< Frame type - The frame holds digit codes
+#define MAX7219_ANIMATION_DELTA_FRAME 0x01      ///< Frame type - The frame holds the XOR of digit codes with the previous frame
+
+/**
+ * @brief Animation player configuration.
+ */
+typedef struct max7219_animation_config {
+    uint8_t start_chain_id;         ///< Device showing the first digit code of each frame, starting at 1 for the first device
+    uint8_t start_digit_id;         ///< Digit showing the first digit code of each frame (1 to 8)
+    bool loop;                      ///< Start over from the first frame after the last frame - Otherwise the last frame stays on display
+} max7219_animation_config_t;
+
+/**
+ * @brief Animation player state. Initialize with `led_driver_max7219_animation_init()` and treat as opaque.
+ */
+typedef struct max7219_animation_player {
+    led_driver_max7219_handle_t handle;     ///< Driver showing the animation
+    max7219_animation_config_t config;      ///< Player configuration
+    const uint8_t* data;                    ///< Animation, header included
+    size_t length;                          ///< Size of the animation, in bytes
+    uint16_t digit_count;                   ///< Digit codes per frame
+    uint16_t frame_count;                   ///< Number of frames
+    uint16_t frame_ms;                      ///< Suggested time between frames, in milliseconds
+    uint16_t frame_index;                   ///< Index of the next frame
+    size_t offset;                          ///< Offset of the next frame in `data`
+    uint8_t* frame;                         ///< Digit codes of the last frame decoded
+    uint8_t* changed;                       ///< One bit per digit code of the last frame decoded, set when the code changed
+    bool shown_valid;                       ///< `frame` matches the display
+} max7219_animation_player_t;
+
+
+/**
+ * @brief Initialize an animation player. Nothing is sent until the first `led_driver_max7219_animation_next()`.
+ *
+ * @param[out] player Player to initialize
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  config Player configuration
+ * @param[in]  data Animation. Must remain valid until the player is released
+ * @param[in]  length Size of 'data', in bytes
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_VERSION: 'data' is not an animation of a supported version
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_animation_init(max7219_animation_player_t* player, led_driver_max7219_handle_t handle, const max7219_animation_config_t* config, const uint8_t* data, size_t length);
+
+/**
+ * @brief Decode the next frame and send the digits which differ from the display.
+ *
+ * @note Frames are decoded token by token straight from 'data', into a single frame of digit codes. Call every `frame_ms` milliseconds.
+ *
+ * @param[in]  player Player to advance
+ * @param[out] finished Optional, receives true once the last frame of an animation which does not loop is on display
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_SIZE: The frame is truncated or corrupt - Rewind before playing again
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_animation_next(max7219_animation_player_t* player, bool* finished);
+
+/**
+ * @brief Go back to the first frame. The next frame only sends the digits which differ from the display.
+ *
+ * @param[in]  player Player to rewind
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_animation_rewind(max7219_animation_player_t* player);
+
+/**
+ * @brief Forget what the player displays so the next frame sends all its digits.
+ *
+ * @param[in]  player Player to invalidate
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_animation_invalidate(max7219_animation_player_t* player);
+
+/**
+ * @brief Release an animation player. The display keeps what it shows.
+ *
+ * @param[in]  player Player to release
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_animation_deinit(max7219_animation_player_t* player);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,357 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#include "max7219_7221.h"
+#include "max7219_7221_orientation.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// A canvas is a 1 bit per pixel drawing surface spanning a panel of 8x8 LED matrix modules, one module per MAX7219 / MAX7221 device.
+// Sprites are drawn on top of the canvas. Changes are tracked per module row: a flush recomposites and sends only the module rows which
+// changed since the last flush. A canvas must only be used by one task at a time.
+//
+// By default, module row 'r' (0 is the top row) is shown on digit 'r + 1' of its device, the leftmost pixel on segment DP (bit 7). Modules wired
+// or mounted otherwise are given a `max7219_orientation_t`, applied to whole modules with 64 bit kernels when rows are sent.
+//
+
+#define MAX7219_CANVAS_MAX_SPRITES 16       ///< Maximum number of sprites on a canvas
+
+/**
+ * @brief How drawn pixels combine with canvas pixels.
+ */
+typedef enum {
+    MAX7219_DRAW_OR = 0,                ///< Turn drawn pixels on
+    MAX7219_DRAW_AND = 1,               ///< Turn off canvas pixels under unlit bitmap pixels - Bitmaps only
+    MAX7219_DRAW_XOR = 2,               ///< Invert drawn pixels
+    MAX7219_DRAW_CLEAR = 3              ///< Turn drawn pixels off
+} max7219_draw_mode_t;
+
+/**
+ * @brief Canvas configuration.
+ * @note Modules are numbered from left to right then from top to bottom: the top left module is shown on device `start_chain_id`,
+ *       the module on its right on device `start_chain_id + 1` and so on.
+ */
+typedef struct max7219_canvas_config {
+    uint8_t start_chain_id;             ///< Device showing the top left module, starting at 1 for the first device
+    uint8_t modules_per_row;            ///< Panel width in modules
+    uint8_t module_rows;                ///< Panel height in modules
+} max7219_canvas_config_t;
+
+/**
+ * @brief Sprite drawn on top of a canvas. Lit bitmap pixels are drawn, unlit pixels are transparent.
+ * @note Change position, visibility or bitmap of a sprite added to a canvas with `led_driver_max7219_canvas_move_sprite()`,
+ *       `led_driver_max7219_canvas_show_sprite()` and `led_driver_max7219_canvas_set_sprite_bitmap()` so the canvas knows what to redraw.
+ */
+typedef struct max7219_sprite {
+    const uint8_t* bitmap;              ///< Packed rows, top row first, `(width + 7) / 8` bytes per row, leftmost pixel in the most significant bit
+    uint8_t width;                      ///< Width in pixels
+    uint8_t height;                     ///< Height in pixels
+    int16_t x;                          ///< Column of the leftmost pixel on the canvas - Can be off canvas
+    int16_t y;                          ///< Row of the top pixel on the canvas - Can be off canvas
+    bool visible;                       ///< Sprite is drawn
+} max7219_sprite_t;
+
+/**
+ * @brief Canvas state. Initialize with `led_driver_max7219_canvas_init()`.
+ */
+typedef struct max7219_canvas {
+    led_driver_max7219_handle_t handle;                     ///< Driver showing the canvas
+    max7219_canvas_config_t config;                         ///< Canvas configuration
+    uint16_t width;                                         ///< Width in pixels
+    uint16_t height;                                        ///< Height in pixels
+    uint8_t* pixels;                                        ///< Packed rows, top row first, `modules_per_row` bytes per row, leftmost pixel in the most significant bit
+    uint8_t* dirty;                                         ///< Rows to recomposite, one byte per module, bit 'r' for module row 'r'
+    uint8_t* shown;                                         ///< Digit registers on display, eight per module
+    uint8_t* orientations;                                  ///< `max7219_orientation_t` of every module
+    bool shown_valid;                                       ///< `shown` matches the display, except for rows left in `dirty` when `shown_unsent` is set
+    bool shown_unsent;                                      ///< A flush timed out - `dirty` also flags rows of `shown` which were not sent
+    max7219_sprite_t* sprites[MAX7219_CANVAS_MAX_SPRITES];  ///< Sprites, drawn in order
+    uint8_t sprite_count;                                   ///< Number of sprites
+} max7219_canvas_t;
+
+
+/**
+ * @brief Initialize a canvas. The canvas is blank and nothing is sent until the first flush, which sends all rows of all modules.
+ *
+ * @param[out] canvas Canvas to initialize
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  config Canvas configuration
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Insufficient memory
+ */
+esp_err_t led_driver_max7219_canvas_init(max7219_canvas_t* canvas, led_driver_max7219_handle_t handle, const max7219_canvas_config_t* config);
+
+/**
+ * @brief Release memory held by a canvas.
+ *
+ * @param[in]  canvas Canvas to release
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_deinit(max7219_canvas_t* canvas);
+
+/**
+ * @brief Turn all canvas pixels off. Sprites are not changed.
+ *
+ * @param[in]  canvas Canvas to clear
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_clear(max7219_canvas_t* canvas);
+
+/**
+ * @brief Turn one canvas pixel on or off. Pixels outside the canvas are ignored.
+ *
+ * @param[in]  canvas Canvas to draw on
+ * @param[in]  x Pixel column
+ * @param[in]  y Pixel row
+ * @param[in]  on Turn the pixel on
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_set_pixel(max7219_canvas_t* canvas, int16_t x, int16_t y, bool on);
+
+/**
+ * @brief Mark a rectangle of the canvas as changed, after writing `pixels` directly.
+ *
+ * @param[in]  canvas Canvas written to
+ * @param[in]  x Leftmost column of the rectangle
+ * @param[in]  y Top row of the rectangle
+ * @param[in]  width Width of the rectangle in pixels
+ * @param[in]  height Height of the rectangle in pixels
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_mark_dirty(max7219_canvas_t* canvas, int16_t x, int16_t y, uint16_t width, uint16_t height);
+
+/**
+ * @brief Draw a line between two points, both included. The line is clipped to the canvas.
+ *
+ * @param[in]  canvas Canvas to draw on
+ * @param[in]  x0 Column of the first point
+ * @param[in]  y0 Row of the first point
+ * @param[in]  x1 Column of the last point
+ * @param[in]  y1 Row of the last point
+ * @param[in]  mode `MAX7219_DRAW_OR`, `MAX7219_DRAW_XOR` or `MAX7219_DRAW_CLEAR`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_draw_line(max7219_canvas_t* canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, max7219_draw_mode_t mode);
+
+/**
+ * @brief Draw the outline of a rectangle. The rectangle is clipped to the canvas.
+ *
+ * @param[in]  canvas Canvas to draw on
+ * @param[in]  x Leftmost column of the rectangle
+ * @param[in]  y Top row of the rectangle
+ * @param[in]  width Width of the rectangle in pixels
+ * @param[in]  height Height of the rectangle in pixels
+ * @param[in]  mode `MAX7219_DRAW_OR`, `MAX7219_DRAW_XOR` or `MAX7219_DRAW_CLEAR`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_draw_rect(max7219_canvas_t* canvas, int16_t x, int16_t y, uint16_t width, uint16_t height, max7219_draw_mode_t mode);
+
+/**
+ * @brief Draw a filled rectangle. The rectangle is clipped to the canvas.
+ *
+ * @param[in]  canvas Canvas to draw on
+ * @param[in]  x Leftmost column of the rectangle
+ * @param[in]  y Top row of the rectangle
+ * @param[in]  width Width of the rectangle in pixels
+ * @param[in]  height Height of the rectangle in pixels
+ * @param[in]  mode `MAX7219_DRAW_OR`, `MAX7219_DRAW_XOR` or `MAX7219_DRAW_CLEAR`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_fill_rect(max7219_canvas_t* canvas, int16_t x, int16_t y, uint16_t width, uint16_t height, max7219_draw_mode_t mode);
+
+/**
+ * @brief Draw the outline of a circle. The circle is clipped to the canvas.
+ *
+ * @param[in]  canvas Canvas to draw on
+ * @param[in]  centerX Column of the center
+ * @param[in]  centerY Row of the center
+ * @param[in]  radius Radius in pixels
+ * @param[in]  mode `MAX7219_DRAW_OR`, `MAX7219_DRAW_XOR` or `MAX7219_DRAW_CLEAR`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_draw_circle(max7219_canvas_t* canvas, int16_t centerX, int16_t centerY, uint16_t radius, max7219_draw_mode_t mode);
+
+/**
+ * @brief Draw a bitmap. The bitmap is clipped to the canvas.
+ *
+ * @param[in]  canvas Canvas to draw on
+ * @param[in]  x Column of the leftmost bitmap pixel
+ * @param[in]  y Row of the top bitmap pixel
+ * @param[in]  bitmap Packed rows, top row first, `(width + 7) / 8` bytes per row, leftmost pixel in the most significant bit
+ * @param[in]  width Width of the bitmap in pixels
+ * @param[in]  height Height of the bitmap in pixels
+ * @param[in]  mode How lit bitmap pixels combine with canvas pixels
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_blit(max7219_canvas_t* canvas, int16_t x, int16_t y, const uint8_t* bitmap, uint8_t width, uint8_t height, max7219_draw_mode_t mode);
+
+/**
+ * @brief Set the orientation of one module or all modules. Modules are `MAX7219_ORIENTATION_NORMAL` by default.
+ *
+ * @param[in]  canvas Canvas to configure
+ * @param[in]  chainId Device showing the module, or 0 for all modules of the canvas
+ * @param[in]  orientation Orientation of the module
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument, e.g. the device does not show a module of this canvas
+ */
+esp_err_t led_driver_max7219_canvas_set_orientation(max7219_canvas_t* canvas, uint8_t chainId, max7219_orientation_t orientation);
+
+/**
+ * @brief Add a sprite on top of a canvas. The sprite must remain valid until it is removed or the canvas is released.
+ *
+ * @param[in]  canvas Canvas to draw the sprite on
+ * @param[in]  sprite Sprite to add
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: The canvas already has `MAX7219_CANVAS_MAX_SPRITES` sprites
+ */
+esp_err_t led_driver_max7219_canvas_add_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite);
+
+/**
+ * @brief Remove a sprite from a canvas.
+ *
+ * @param[in]  canvas Canvas the sprite is drawn on
+ * @param[in]  sprite Sprite to remove
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NOT_FOUND: The sprite is not on this canvas
+ */
+esp_err_t led_driver_max7219_canvas_remove_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite);
+
+/**
+ * @brief Move a sprite.
+ *
+ * @param[in]  canvas Canvas the sprite is drawn on
+ * @param[in]  sprite Sprite to move
+ * @param[in]  x New column of the leftmost sprite pixel
+ * @param[in]  y New row of the top sprite pixel
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_move_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite, int16_t x, int16_t y);
+
+/**
+ * @brief Show or hide a sprite.
+ *
+ * @param[in]  canvas Canvas the sprite is drawn on
+ * @param[in]  sprite Sprite to show or hide
+ * @param[in]  visible Show the sprite
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_show_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite, bool visible);
+
+/**
+ * @brief Change the bitmap of a sprite, e.g. to animate it. Also call after changing the content of the current bitmap.
+ *
+ * @param[in]  canvas Canvas the sprite is drawn on
+ * @param[in]  sprite Sprite to change
+ * @param[in]  bitmap New bitmap, same packing as `max7219_sprite_t.bitmap`
+ * @param[in]  width New width in pixels
+ * @param[in]  height New height in pixels
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_set_sprite_bitmap(max7219_canvas_t* canvas, max7219_sprite_t* sprite, const uint8_t* bitmap, uint8_t width, uint8_t height);
+
+/**
+ * @brief Send changes to the display. Module rows changed since the last flush are recomposited from the canvas and sprites, and only rows
+ *        which differ from the display are sent.
+ *
+ * @param[in]  canvas Canvas to send
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_canvas_flush(max7219_canvas_t* canvas);
+
+/**
+ * @brief Same as `led_driver_max7219_canvas_flush()`, waiting at most `ticksToWait` for the driver to be available.
+ * @note When the driver stays busy, the rows which were due are kept and sent by the next flush.
+ *
+ * @param[in]  canvas Canvas to send
+ * @param[in]  ticksToWait Maximum time to wait for the driver, in ticks. 0 returns right away when the driver is busy
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ *      - ESP_ERR_TIMEOUT: The driver was busy for `ticksToWait` - Nothing was sent
+ */
+esp_err_t led_driver_max7219_canvas_flush_timeout(max7219_canvas_t* canvas, TickType_t ticksToWait);
+
+/**
+ * @brief Same as `led_driver_max7219_canvas_flush_timeout()` without waiting: returns `ESP_ERR_TIMEOUT` right away when the driver is busy.
+ */
+esp_err_t led_driver_max7219_canvas_try_flush(max7219_canvas_t* canvas);
+
+/**
+ * @brief Forget what the display shows so the next flush sends all rows of all modules. Call after writing the canvas digits by other means.
+ *
+ * @param[in]  canvas Canvas to invalidate
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_canvas_invalidate(max7219_canvas_t* canvas);
+
+#ifdef __cplusplus
+}
+#endif
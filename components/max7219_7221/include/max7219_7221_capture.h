@@ -0,0 +1,45 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// SPI capture stream, as returned by `led_driver_max7219_read_capture()`. Only depends on <stdint.h> so host tools can include it.
+// A stream is a sequence of chunks. Each chunk is a `max7219_capture_header_t` followed by `record_count` records. Each record is
+// a `max7219_capture_record_t` followed by `chain_length * 2` bytes: the chain transfer in wire order (last device first). All fields are little endian.
+//
+
+#define MAX7219_CAPTURE_MAGIC 0x5043374DUL    ///< "M7CP" read as a little endian uint32_t
+#define MAX7219_CAPTURE_VERSION 1             ///< Version of the capture stream format
+
+/**
+ * @brief Header of a capture chunk.
+ */
+typedef struct max7219_capture_header {
+    uint32_t magic;                     ///< `MAX7219_CAPTURE_MAGIC`
+    uint8_t version;                    ///< `MAX7219_CAPTURE_VERSION`
+    uint8_t chain_length;               ///< Number of devices on the chain
+    uint16_t record_count;              ///< Number of records following this header
+    uint32_t clock_speed_hz;            ///< Actual SPI clock speed
+    uint32_t dropped_records;           ///< Number of records overwritten before they could be read, since the previous chunk
+} __attribute__((packed)) max7219_capture_header_t;
+
+/**
+ * @brief Header of one captured chain transfer.
+ */
+typedef struct max7219_capture_record {
+    uint32_t timestamp_us;              ///< Low 32 bits of `esp_timer_get_time()` when the transfer started
+    uint16_t duration_us;               ///< Time spent transmitting, saturated to 65535 µs. Time spent handing the transfer to a bus coordinator for coordinated chains
+} __attribute__((packed)) max7219_capture_record_t;
+
+#ifdef __cplusplus
+}
+#endif
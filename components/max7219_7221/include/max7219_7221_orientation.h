@@ -0,0 +1,99 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// 8x8 LED matrix module orientation. Only depends on <stdint.h> so host tools can include it.
+// An 8x8 module is held in a `uint64_t`: row 'r' (0 is the top row) in bits '8 * r' to '8 * r + 7', the leftmost pixel of a row in the
+// most significant bit of its byte. Kernels work on the whole module at once with 64 bit shifts and masks, without branches.
+//
+
+/**
+ * @brief Orientation of an 8x8 LED matrix module, as the transform from module pixels to digit registers: transpose first, then mirror.
+ * @note Digit register 'r + 1' drives row 'r' of the transformed module, segment DP (bit 7) its leftmost pixel.
+ */
+typedef enum {
+    MAX7219_ORIENTATION_NORMAL = 0x00,          ///< Digit registers drive rows, segment DP the leftmost column
+    MAX7219_ORIENTATION_MIRROR_X = 0x01,        ///< Mirrored left to right - Segment DP drives the rightmost column
+    MAX7219_ORIENTATION_MIRROR_Y = 0x02,        ///< Mirrored top to bottom - Digit 1 drives the bottom row
+    MAX7219_ORIENTATION_TRANSPOSE = 0x04,       ///< Digit registers drive columns, segment DP the top row
+
+    MAX7219_ORIENTATION_ROTATE_90 = MAX7219_ORIENTATION_TRANSPOSE | MAX7219_ORIENTATION_MIRROR_X,   ///< Rotated 90 degrees clockwise
+    MAX7219_ORIENTATION_ROTATE_180 = MAX7219_ORIENTATION_MIRROR_X | MAX7219_ORIENTATION_MIRROR_Y,   ///< Rotated 180 degrees
+    MAX7219_ORIENTATION_ROTATE_270 = MAX7219_ORIENTATION_TRANSPOSE | MAX7219_ORIENTATION_MIRROR_Y,  ///< Rotated 90 degrees counter clockwise
+    MAX7219_ORIENTATION_ANTI_TRANSPOSE = MAX7219_ORIENTATION_TRANSPOSE | MAX7219_ORIENTATION_MIRROR_X | MAX7219_ORIENTATION_MIRROR_Y  ///< Transposed along the other diagonal
+} max7219_orientation_t;
+
+
+/**
+ * @brief Pack eight rows, top row first, into a `uint64_t`.
+ */
+static inline uint64_t max7219_pack_rows(const uint8_t rows[8]) {
+    return (uint64_t) rows[0] | ((uint64_t) rows[1] << 8) | ((uint64_t) rows[2] << 16) | ((uint64_t) rows[3] << 24) |
+           ((uint64_t) rows[4] << 32) | ((uint64_t) rows[5] << 40) | ((uint64_t) rows[6] << 48) | ((uint64_t) rows[7] << 56);
+}
+
+/**
+ * @brief Unpack a `uint64_t` into eight rows, top row first.
+ */
+static inline void max7219_unpack_rows(uint64_t module, uint8_t rows[8]) {
+    for (uint8_t row = 0; row < 8; row++) {
+        rows[row] = (uint8_t) (module >> (8 * row));
+    }
+}
+
+/**
+ * @brief Swap rows and columns - Pixel (row, column) moves to (column, row). Three delta swaps of 2x2, 4x4 then 8x8 bit blocks.
+ */
+static inline uint64_t max7219_transpose(uint64_t module) {
+    uint64_t swap = (module ^ (module >> 9)) & 0x0055005500550055ULL;
+    module ^= swap ^ (swap << 9);
+    swap = (module ^ (module >> 18)) & 0x0000333300003333ULL;
+    module ^= swap ^ (swap << 18);
+    swap = (module ^ (module >> 36)) & 0x000000000F0F0F0FULL;
+    module ^= swap ^ (swap << 36);
+    return module;
+}
+
+/**
+ * @brief Mirror left to right - Reverse the bits of every row.
+ */
+static inline uint64_t max7219_mirror_x(uint64_t module) {
+    module = ((module >> 1) & 0x5555555555555555ULL) | ((module & 0x5555555555555555ULL) << 1);
+    module = ((module >> 2) & 0x3333333333333333ULL) | ((module & 0x3333333333333333ULL) << 2);
+    module = ((module >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((module & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return module;
+}
+
+/**
+ * @brief Mirror top to bottom - Reverse the order of rows.
+ */
+static inline uint64_t max7219_mirror_y(uint64_t module) {
+    return __builtin_bswap64(module);
+}
+
+/**
+ * @brief Transform module pixels into digit register rows for the given orientation. Each step is selected with a mask rather than a branch.
+ */
+static inline uint64_t max7219_orient(uint64_t module, max7219_orientation_t orientation) {
+    uint64_t select = 0 - (uint64_t) ((orientation >> 2) & 1);
+    module ^= (module ^ max7219_transpose(module)) & select;
+    select = 0 - (uint64_t) (orientation & 1);
+    module ^= (module ^ max7219_mirror_x(module)) & select;
+    select = 0 - (uint64_t) ((orientation >> 1) & 1);
+    module ^= (module ^ max7219_mirror_y(module)) & select;
+    return module;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#include "max7219_7221_canvas.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Transitions take a canvas from what it shows to a new frame over several ticks. Each tick only changes the canvas pixels the effect moves
+// and flushes the canvas, which sends only the module rows which changed. Ticks are either driven by a driver timer or by the application.
+// While a transition runs, the canvas belongs to the transition.
+//
+
+/**
+ * @brief Transition effects.
+ */
+typedef enum {
+    MAX7219_TRANSITION_WIPE = 0,            ///< The new frame replaces the old one column by column, from left to right. One tick per column
+    MAX7219_TRANSITION_SLIDE = 1,           ///< The new frame pushes the old one out to the left. One tick per column
+    MAX7219_TRANSITION_DISSOLVE = 2,        ///< Pixels switch to the new frame in a pseudo random order given by a linear feedback shift register
+    MAX7219_TRANSITION_SEGMENTS = 3         ///< Digits build up segment by segment, from segment A to segment DP. Eight ticks. On matrix modules, column by column within each module
+} max7219_transition_effect_t;
+
+typedef struct max7219_transition max7219_transition_t;
+
+/**
+ * @brief Function called, from the timer task, when a timer driven transition completes. It may start the transition again.
+ */
+typedef void (*max7219_transition_done_t)(max7219_transition_t* transition, void* arg);
+
+/**
+ * @brief Transition configuration.
+ */
+typedef struct max7219_transition_config {
+    max7219_transition_effect_t effect;     ///< Effect
+    uint16_t dissolve_ticks;                ///< Number of ticks of `MAX7219_TRANSITION_DISSOLVE` - 16 when 0
+    uint32_t tick_ms;                       ///< Time between ticks driven by a driver timer, or 0 for ticks driven by `led_driver_max7219_transition_step()`
+    max7219_transition_done_t on_done;      ///< Optional, called when a timer driven transition completes
+    void* on_done_arg;                      ///< Argument given to `on_done`
+} max7219_transition_config_t;
+
+/**
+ * @brief Transition state. Initialize with `led_driver_max7219_transition_init()` and treat as opaque.
+ */
+struct max7219_transition {
+    max7219_canvas_t* canvas;               ///< Canvas the transition runs on
+    max7219_transition_config_t config;     ///< Transition configuration
+    const uint8_t* target;                  ///< Frame to transition to
+    uint16_t tick;                          ///< Ticks done
+    uint16_t tick_count;                    ///< Ticks of the whole transition
+    uint16_t lfsr;                          ///< Dissolve - Linear feedback shift register state
+    uint16_t lfsr_taps;                     ///< Dissolve - Linear feedback shift register taps
+    uint16_t pixels_per_tick;               ///< Dissolve - Pixels switched per tick
+    struct esp_timer* timer;                ///< Timer driving ticks (`esp_timer_handle_t`), or NULL
+    volatile bool done;                     ///< The canvas holds the target frame
+    bool flush_pending;                     ///< The driver was busy on the last timer tick - The target frame is not sent yet
+    portMUX_TYPE lock;                      ///< Guards `ticking` and `stopping`
+    bool ticking;                           ///< The timer callback is running a tick
+    bool stopping;                          ///< `led_driver_max7219_transition_start()` or `led_driver_max7219_transition_deinit()` is stopping the timer
+};
+
+
+/**
+ * @brief Initialize a transition on a canvas.
+ *
+ * @param[out] transition Transition to initialize
+ * @param[in]  canvas Canvas the transition runs on
+ * @param[in]  config Transition configuration
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Insufficient memory for the timer
+ *      - ESP_ERR_NOT_SUPPORTED: A timer driven transition was requested with `CONFIG_MAX_7219_7221_SINGLE_OWNER`
+ */
+esp_err_t led_driver_max7219_transition_init(max7219_transition_t* transition, max7219_canvas_t* canvas, const max7219_transition_config_t* config);
+
+/**
+ * @brief Start a transition from what the canvas holds to a new frame. A transition in progress is abandoned where it is.
+ *
+ * @note When timer driven, the first tick runs after `tick_ms` and this function returns once a tick already running, if any, completes. Ticks never
+ *       wait for a busy driver: the pixels of a tick which could not be sent go out with the next tick.
+ *
+ * @param[in]  transition Transition to start
+ * @param[in]  target New frame, laid out as `max7219_canvas_t.pixels`. Must remain valid until the transition is done
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_transition_start(max7219_transition_t* transition, const uint8_t* target);
+
+/**
+ * @brief Run one tick of a transition driven by the application.
+ *
+ * @param[in]  transition Transition to advance
+ * @param[out] done Optional, receives true once the canvas shows the target frame
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The transition is driven by a timer or the driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_transition_step(max7219_transition_t* transition, bool* done);
+
+/**
+ * @brief Check whether the canvas shows the target frame.
+ *
+ * @param[in]  transition Transition to check
+ *
+ * @return true when the transition is done or was never started
+ */
+bool led_driver_max7219_transition_is_done(const max7219_transition_t* transition);
+
+/**
+ * @brief Stop a transition and release its timer, after a tick already running, if any, completes. The canvas keeps what it shows.
+ *
+ * @param[in]  transition Transition to release
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_transition_deinit(max7219_transition_t* transition);
+
+#ifdef __cplusplus
+}
+#endif
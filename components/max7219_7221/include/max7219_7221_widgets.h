@@ -0,0 +1,365 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <esp_err.h>
+
+#include "max7219_7221.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Widgets render application values on a range of digits and only send the digits which changed since the last update.
+// Widget state lives in caller provided structures - No memory is allocated, except the timer of a timer driven clock. A widget must only be updated by one task at a time.
+//
+
+#define MAX7219_COUNTER_MAX_DIGITS 10     ///< Maximum number of digits of a counter - Enough for any `uint32_t` value
+#define MAX7219_WIDGET_MAX_DIGITS 32      ///< Maximum number of digits of a bar graph or a sparkline
+#define MAX7219_CLOCK_MAX_DIGITS 6        ///< Maximum number of digits of a clock
+
+/**
+ * @brief Counter configuration.
+ * @note The least significant digit is shown on digit `start_digit_id` of device `start_chain_id`. More significant digits are shown on the
+ *       following digits, continuing on digit 1 of the next device. Values with more than `digit_count` digits are shown modulo 10^`digit_count`, as an odometer would.
+ */
+typedef struct max7219_counter_config {
+    uint8_t start_chain_id;         ///< Device showing the least significant digit, starting at 1 for the first device
+    uint8_t start_digit_id;         ///< Digit showing the least significant digit (1 to 8)
+    uint8_t digit_count;            ///< Number of digits of the counter (1 to `MAX7219_COUNTER_MAX_DIGITS`)
+    bool code_b;                    ///< Digits are in Code B decode mode - Otherwise digits are in no decode mode and are drawn with `max7219_direct_addressing_font_t` symbols
+    bool leading_zeros;             ///< Show leading zeros - Otherwise leading zeros are blank
+} max7219_counter_config_t;
+
+/**
+ * @brief Counter state. Initialize with `led_driver_max7219_counter_init()` and treat as opaque.
+ */
+typedef struct max7219_counter {
+    led_driver_max7219_handle_t handle;             ///< Driver showing the counter
+    max7219_counter_config_t config;                ///< Counter configuration
+    uint32_t value;                                 ///< Current value
+    uint8_t bcd[MAX7219_COUNTER_MAX_DIGITS];        ///< Current value, one decimal digit per byte, least significant digit first
+    uint8_t shown[MAX7219_COUNTER_MAX_DIGITS];      ///< Digit codes on display, least significant digit first
+    bool shown_valid;                               ///< `shown` matches the display
+} max7219_counter_t;
+
+
+/**
+ * @brief Initialize a counter. Nothing is sent until the first update, which sends all digits of the counter.
+ *
+ * @param[out] counter Counter to initialize
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  config Counter configuration
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_counter_init(max7219_counter_t* counter, led_driver_max7219_handle_t handle, const max7219_counter_config_t* config);
+
+/**
+ * @brief Show a value on a counter. Only digits which differ from the display are sent.
+ *
+ * @note The value is converted to decimal with shifts and adds, without any division.
+ *
+ * @param[in]  counter Counter to update
+ * @param[in]  value Value to show
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_counter_set(max7219_counter_t* counter, uint32_t value);
+
+/**
+ * @brief Add one to a counter. Only digits which differ from the display are sent.
+ *
+ * @note The decimal digits are incremented in place and the carry only ripples through trailing nines - Going from 1999 to 2000 sends 4 digits, from 2000 to 2001 sends 1 digit.
+ *
+ * @param[in]  counter Counter to update
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_counter_increment(max7219_counter_t* counter);
+
+/**
+ * @brief Forget what a counter displays so the next update sends all its digits. Call after the counter digits were written by other means.
+ *
+ * @param[in]  counter Counter to invalidate
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_counter_invalidate(max7219_counter_t* counter);
+
+
+
+/**
+ * @brief How bar graphs and sparklines are drawn.
+ */
+typedef enum {
+    MAX7219_WIDGET_STYLE_SEGMENTS = 0,  ///< Seven-segment digits in no decode mode - Bar graphs light segments F / E and B / C, two steps per digit. Sparklines light segment D, G or A, three steps per digit
+    MAX7219_WIDGET_STYLE_COLUMNS = 1    ///< LED matrices - Each digit register is a column of 8 LEDs, bit 0 first. Eight steps per digit
+} max7219_widget_style_t;
+
+/**
+ * @brief Bar graph configuration.
+ * @note With `MAX7219_WIDGET_STYLE_SEGMENTS`, the bar graph is one bar across `digit_count` digits and takes one sample per update.
+ *       With `MAX7219_WIDGET_STYLE_COLUMNS`, each digit is a bar of its own and the bar graph takes `digit_count` samples per update.
+ *       Displayed levels follow samples with an exponential attack / decay: every update moves the level 1/2^`attack_shift` of the way
+ *       up to a larger sample, or 1/2^`decay_shift` of the way down to a smaller sample.
+ */
+typedef struct max7219_bargraph_config {
+    uint8_t start_chain_id;         ///< Device of the first digit, starting at 1 for the first device
+    uint8_t start_digit_id;         ///< First digit (1 to 8)
+    uint8_t digit_count;            ///< Number of digits of the bar graph (1 to `MAX7219_WIDGET_MAX_DIGITS`)
+    max7219_widget_style_t style;   ///< How bars are drawn
+    bool reverse;                   ///< Reverse the drawing direction - Segment bars grow from the first digit, the rightmost digit on common modules, and column bars grow from bit 0 unless reversed
+    uint16_t full_scale;            ///< Sample value lighting a whole bar. Must not be 0, larger samples are clamped
+    uint8_t attack_shift;           ///< Attack speed, 0 (instant) to 15 (slowest)
+    uint8_t decay_shift;            ///< Decay speed, 0 (instant) to 15 (slowest)
+    uint16_t peak_hold_updates;     ///< Number of updates a peak is held before it falls back one step per update. 0 disables peak indicators
+} max7219_bargraph_config_t;
+
+/**
+ * @brief Bar graph state. Initialize with `led_driver_max7219_bargraph_init()` and treat as opaque.
+ */
+typedef struct max7219_bargraph {
+    led_driver_max7219_handle_t handle;                 ///< Driver showing the bar graph
+    max7219_bargraph_config_t config;                   ///< Bar graph configuration
+    uint8_t resolution;                                 ///< Number of steps of a bar
+    uint32_t scale_q16;                                 ///< Steps per sample unit, 16.16 fixed point
+    uint32_t levels_q8[MAX7219_WIDGET_MAX_DIGITS];      ///< Smoothed level of each bar in sample units, 24.8 fixed point
+    uint8_t peaks[MAX7219_WIDGET_MAX_DIGITS];           ///< Peak of each bar, in steps
+    uint16_t peak_holds[MAX7219_WIDGET_MAX_DIGITS];     ///< Remaining updates before the peak of each bar falls
+    uint8_t shown[MAX7219_WIDGET_MAX_DIGITS];           ///< Digit codes on display
+    bool shown_valid;                                   ///< `shown` matches the display
+} max7219_bargraph_t;
+
+/**
+ * @brief Sparkline configuration.
+ * @note A sparkline shows the last `digit_count` samples, one sample per digit. The newest sample is on the first digit, the rightmost digit on common modules,
+ *       and older samples scroll towards the last digit unless `reverse` is set.
+ */
+typedef struct max7219_sparkline_config {
+    uint8_t start_chain_id;         ///< Device of the first digit, starting at 1 for the first device
+    uint8_t start_digit_id;         ///< First digit (1 to 8)
+    uint8_t digit_count;            ///< Number of digits of the sparkline (1 to `MAX7219_WIDGET_MAX_DIGITS`)
+    max7219_widget_style_t style;   ///< How samples are drawn
+    bool reverse;                   ///< Show the newest sample on the last digit
+    bool filled;                    ///< `MAX7219_WIDGET_STYLE_COLUMNS` only - Light the whole column up to the sample instead of a single LED
+    uint16_t full_scale;            ///< Sample value drawn on the top step. Must not be 0, larger samples are clamped
+} max7219_sparkline_config_t;
+
+/**
+ * @brief Sparkline state. Initialize with `led_driver_max7219_sparkline_init()` and treat as opaque.
+ */
+typedef struct max7219_sparkline {
+    led_driver_max7219_handle_t handle;                 ///< Driver showing the sparkline
+    max7219_sparkline_config_t config;                  ///< Sparkline configuration
+    uint8_t resolution;                                 ///< Number of steps of a digit
+    uint32_t scale_q16;                                 ///< Steps per sample unit, 16.16 fixed point
+    uint8_t history[MAX7219_WIDGET_MAX_DIGITS];         ///< Ring of the last samples, in steps
+    uint8_t head;                                       ///< Index of the newest sample in `history`
+    uint8_t count;                                      ///< Number of samples in `history`
+    uint8_t shown[MAX7219_WIDGET_MAX_DIGITS];           ///< Digit codes on display
+    bool shown_valid;                                   ///< `shown` matches the display
+} max7219_sparkline_t;
+
+
+/**
+ * @brief Initialize a bar graph. Nothing is sent until the first update, which sends all digits of the bar graph.
+ *
+ * @param[out] bargraph Bar graph to initialize
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  config Bar graph configuration
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_bargraph_init(max7219_bargraph_t* bargraph, led_driver_max7219_handle_t handle, const max7219_bargraph_config_t* config);
+
+/**
+ * @brief Feed samples to a bar graph. Only digits which differ from the display are sent.
+ *
+ * @param[in]  bargraph Bar graph to update
+ * @param[in]  samples One sample with `MAX7219_WIDGET_STYLE_SEGMENTS`, `digit_count` samples (one per bar) with `MAX7219_WIDGET_STYLE_COLUMNS`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_bargraph_update(max7219_bargraph_t* bargraph, const uint16_t samples[]);
+
+/**
+ * @brief Forget what a bar graph displays so the next update sends all its digits.
+ *
+ * @param[in]  bargraph Bar graph to invalidate
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_bargraph_invalidate(max7219_bargraph_t* bargraph);
+
+/**
+ * @brief Initialize a sparkline with an empty history. Nothing is sent until the first push, which sends all digits of the sparkline.
+ *
+ * @param[out] sparkline Sparkline to initialize
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  config Sparkline configuration
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_sparkline_init(max7219_sparkline_t* sparkline, led_driver_max7219_handle_t handle, const max7219_sparkline_config_t* config);
+
+/**
+ * @brief Append samples to a sparkline history and redraw it once. Only digits which differ from the display are sent.
+ *
+ * @param[in]  sparkline Sparkline to update
+ * @param[in]  samples Samples to append, oldest first
+ * @param[in]  samplesCount Number of samples in 'samples'
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_sparkline_push(max7219_sparkline_t* sparkline, const uint16_t samples[], uint16_t samplesCount);
+
+/**
+ * @brief Forget what a sparkline displays so the next push sends all its digits.
+ *
+ * @param[in]  sparkline Sparkline to invalidate
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_sparkline_invalidate(max7219_sparkline_t* sparkline);
+
+
+
+/**
+ * @brief What a clock shows, from its most significant digit to its least significant digit.
+ */
+typedef enum {
+    MAX7219_CLOCK_LAYOUT_HH_MM = 0,         ///< Hours and minutes - 4 digits
+    MAX7219_CLOCK_LAYOUT_HH_MM_SS = 1,      ///< Hours, minutes and seconds - 6 digits
+    MAX7219_CLOCK_LAYOUT_DD_MM_YY = 2,      ///< Day, month and year - 6 digits
+    MAX7219_CLOCK_LAYOUT_MM_DD_YY = 3       ///< Month, day and year - 6 digits
+} max7219_clock_layout_t;
+
+/**
+ * @brief How a clock separates its fields. Separators are the decimal point (`MAX7219_SEGMENT_DP`) of the digit on the left of each separator.
+ */
+typedef enum {
+    MAX7219_CLOCK_SEPARATOR_NONE = 0,       ///< No separator
+    MAX7219_CLOCK_SEPARATOR_STEADY = 1,     ///< Separators always lit
+    MAX7219_CLOCK_SEPARATOR_BLINK = 2       ///< The first separator is lit during the first half of each second, other separators are always lit
+} max7219_clock_separator_t;
+
+/**
+ * @brief Clock configuration.
+ * @note The least significant digit is shown on digit `start_digit_id` of device `start_chain_id`, as with counters. A timer driven clock reads the
+ *       system time with `localtime_r()` on every second, and every half second with a blinking separator. Most seconds, it sends the one or two digits which changed.
+ *       The timer never waits for a busy driver - It tries again 10 ms later instead. It may still wait for the SPI bus when other devices share the
+ *       SPI host, unless the bus is kept between operations or shared through a bus coordinator.
+ */
+typedef struct max7219_clock_config {
+    uint8_t start_chain_id;                 ///< Device showing the least significant digit, starting at 1 for the first device
+    uint8_t start_digit_id;                 ///< Digit showing the least significant digit (1 to 8)
+    max7219_clock_layout_t layout;          ///< What the clock shows
+    max7219_clock_separator_t separator;    ///< How fields are separated
+    bool code_b;                            ///< Digits are in Code B decode mode - Otherwise digits are in no decode mode and are drawn with `max7219_direct_addressing_font_t` symbols
+    bool hour_12;                           ///< Show hours from 1 to 12 with a blank leading zero - Otherwise show hours from 00 to 23
+    bool timer_driven;                      ///< Update the clock from the system time with a driver timer - Otherwise the application calls `led_driver_max7219_clock_show()`
+} max7219_clock_config_t;
+
+/**
+ * @brief Clock state. Initialize with `led_driver_max7219_clock_init()` and treat as opaque.
+ */
+typedef struct max7219_clock {
+    led_driver_max7219_handle_t handle;             ///< Driver showing the clock
+    max7219_clock_config_t config;                  ///< Clock configuration
+    uint8_t digit_count;                            ///< Number of digits of the layout
+    uint8_t shown[MAX7219_CLOCK_MAX_DIGITS];        ///< Digit codes on display, least significant digit first
+    bool shown_valid;                               ///< `shown` matches the display
+    struct esp_timer* timer;                        ///< Timer updating a timer driven clock (`esp_timer_handle_t`), or NULL
+    portMUX_TYPE lock;                              ///< Guards `updating` and `stopping`
+    bool updating;                                  ///< The timer callback is updating the clock
+    bool stopping;                                  ///< `led_driver_max7219_clock_deinit()` is stopping the timer
+} max7219_clock_t;
+
+
+/**
+ * @brief Initialize a clock. A timer driven clock starts showing the system time right away, from the timer task. Other clocks send nothing until the first `led_driver_max7219_clock_show()`.
+ *
+ * @param[out] clockWidget Clock to initialize
+ * @param[in]  handle Handle to the MAX7219 / MAX7221 driver
+ * @param[in]  config Clock configuration
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: Insufficient memory for the timer
+ *      - ESP_ERR_NOT_SUPPORTED: A timer driven clock was requested with `CONFIG_MAX_7219_7221_SINGLE_OWNER`
+ */
+esp_err_t led_driver_max7219_clock_init(max7219_clock_t* clockWidget, led_driver_max7219_handle_t handle, const max7219_clock_config_t* config);
+
+/**
+ * @brief Show a time or a date on a clock. Only digits which differ from the display are sent.
+ *
+ * @param[in]  clockWidget Clock to update
+ * @param[in]  localTime Broken down time to show - Only the fields of the clock layout are read
+ * @param[in]  separatorLit Light the blinking separator - Ignored unless the clock separator is `MAX7219_CLOCK_SEPARATOR_BLINK`
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_STATE: The driver is in an invalid state
+ */
+esp_err_t led_driver_max7219_clock_show(max7219_clock_t* clockWidget, const struct tm* localTime, bool separatorLit);
+
+/**
+ * @brief Forget what a clock displays so the next update sends all its digits.
+ *
+ * @param[in]  clockWidget Clock to invalidate
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_clock_invalidate(max7219_clock_t* clockWidget);
+
+/**
+ * @brief Stop a clock and release its timer, after the update in progress on the timer task, if any, completes. The display keeps what it shows.
+ *
+ * @param[in]  clockWidget Clock to release
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t led_driver_max7219_clock_deinit(max7219_clock_t* clockWidget);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,10 +5,13 @@
 #include <string.h>
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <esp_attr.h>
 #include <esp_check.h>
+#include <esp_timer.h>
 
 #include "max7219_7221.h"
+#include "max7219_7221_bus.h"
 
 
 DRAM_ATTR static const char* LedDriverMax7219LogTag = "leddriver_max72[19|21]";
@@ -37,6 +40,12 @@ typedef struct max7219_command {
     uint8_t data;
 }  __attribute__((packed)) max7219_command_t;
 
+#ifdef MAX7219_FIXED_CHAIN_LENGTH
+// With a compile time chain length, the command buffer is embedded in the (DMA capable) driver context
+typedef struct max7219_chain_commands {
+    max7219_command_t commands_data[MAX7219_FIXED_CHAIN_LENGTH];
+} __attribute__((aligned(4))) max7219_chain_commands_t;
+#else
 typedef struct max7219_chain_commands {
     bool use_inline_buffer;
     union {
@@ -44,8 +53,104 @@ typedef struct max7219_chain_commands {
         max7219_command_t* commands_buffer;
     };
 } __attribute__((packed)) max7219_chain_commands_t;
+#endif
+
+// Front / back frame buffers - Each buffer holds 'chain_length * MAX7219_MAX_DIGIT' digit codes, see MAX7219_FRAME_INDEX()
+//  * 'back' is owned by the producer, 'ready' holds the last published frame, 'spare' is owned by the flush path,
+//  * 'shown' is what the chain currently displays. Only pointers are exchanged under 'lock', never frame contents
+typedef struct max7219_frame_buffers {
+    portMUX_TYPE lock;
+    bool frame_pending;
+    bool shown_valid;
+    uint32_t foreign_writes;
+    uint8_t* back;
+    uint8_t* ready;
+    uint8_t* spare;
+    uint8_t* shown;
+    uint8_t* pending_digits;
+} max7219_frame_buffers_t;
+
+// Latest-value-wins digit mailbox - 'codes' is laid out as a frame (see MAX7219_FRAME_INDEX()), 'pending_digits[chainId - 1]' has bit (digit - 1) set for each staged digit
+typedef struct max7219_digit_mailbox {
+    portMUX_TYPE lock;
+    volatile bool pending;
+    int64_t oldest_us;
+    uint8_t* codes;
+    uint8_t* pending_digits;
+} max7219_digit_mailbox_t;
+
+// Urgent and background updates are staged in mailboxes and drained by whichever task owns the driver mutex:
+//  * Urgent digits are sent after the current chain transfer, ahead of the remaining transfers of a bulk operation,
+//  * Background digits are sent when the owner is about to release the driver
+typedef struct max7219_priority_classes {
+    max7219_digit_mailbox_t urgent;
+    max7219_digit_mailbox_t background;
+    bool draining;
+    uint8_t* drain_codes;
+    uint8_t* drain_digits;
+    portMUX_TYPE stats_lock;
+    max7219_priority_latency_t stats;
+} max7219_priority_classes_t;
+
+// Register mirror and power policy state - 'registers[chainIndex * 16 + address]' is the last value sent to 'address' of device 'chainIndex + 1'
+// and 'known_registers[chainIndex]' has bit 'address' set once that register was written. Devices in 'auto_shutdown' were put in shutdown by the policy
+typedef struct max7219_power_manager {
+    max7219_power_policy_t policy;
+    esp_timer_handle_t idle_timer;
+    bool sending;
+    bool idle_shutdown;
+    uint8_t* registers;
+    uint16_t* known_registers;
+    uint8_t* auto_shutdown;
+} max7219_power_manager_t;
+
+// Write combining - Digits written while 'window_us' is not 0 are staged in 'mailbox' and sent together when 'window_timer' fires.
+// 'error' holds the failure of the last coalesced update sent by the timer, under the mailbox lock, until the next combined write reports it
+typedef struct max7219_write_combiner {
+    max7219_digit_mailbox_t mailbox;
+    volatile uint32_t window_us;
+    esp_timer_handle_t window_timer;
+    esp_err_t error;
+    uint8_t* drain_codes;
+    uint8_t* drain_digits;
+} max7219_write_combiner_t;
+
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+// Latency histograms - 'transmit_us' accumulates SPI transmit time of the operation in progress and is only accessed under the driver mutex
+typedef struct max7219_latency_tracer {
+    portMUX_TYPE lock;
+    int64_t transmit_us;
+    max7219_latency_trace_t trace;
+} max7219_latency_tracer_t;
+#endif
+
+#if CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+// Ring of captured chain transfers - Records have a fixed size, 'record_size', so the oldest record can be overwritten in place. 'head' is the oldest record
+typedef struct max7219_capture_ring {
+    portMUX_TYPE lock;
+    uint32_t clock_speed_hz;
+    uint32_t dropped;
+    uint16_t record_size;
+    uint16_t capacity;
+    uint16_t head;
+    uint16_t count;
+    uint8_t records[];
+} max7219_capture_ring_t;
+#endif
 
 typedef struct led_driver_max7219_context led_driver_max7219_context_t;
+
+// Compiled register command script - 'frames' holds 'frame_count' chain transfers in wire order, in DMA capable memory, and 'transactions' sends them
+typedef struct max7219_script max7219_script_t;
+struct max7219_script {
+    led_driver_max7219_context_t* driver_context;
+    uint16_t frame_count;
+    bool writes_digits;
+    spi_transaction_t* transactions;
+    max7219_command_t* frames;
+};
+
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
 typedef struct led_driver_max7219_base {
     esp_err_t (*configure_decode)(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_decode_mode_t decodeMode);
     esp_err_t (*configure_scan_limit)(led_driver_max7219_context_t* driver_context, uint8_t chainId, uint8_t digits);
@@ -53,15 +158,42 @@ typedef struct led_driver_max7219_base {
     esp_err_t (*set_intensity)(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_intensity_t intensity);
     esp_err_t (*set_digits)(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount);
 } led_driver_max7219_base_t;
+#endif
 
+// Pointers first, then narrower fields, so the context carries as little padding as possible. Keep in sync with LED_DRIVER_MAX7219_CONTEXT_SIZE
 typedef struct led_driver_max7219_context {
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
     led_driver_max7219_base_t api;
-    max7219_hw_config_t hw_config;
-    spi_device_handle_t spi_device_handle;
     SemaphoreHandle_t mutex;
+#endif
+    spi_device_handle_t spi_device_handle;
+    max7219_bus_chain_t* bus_chain;
+    max7219_frame_buffers_t* frame_buffers;
+    max7219_priority_classes_t* priority_classes;
+    max7219_power_manager_t* power_manager;
+    max7219_write_combiner_t* write_combiner;
+    esp_timer_handle_t bus_release_timer;
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    max7219_latency_tracer_t* latency_tracer;
+#endif
+#if CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+    max7219_capture_ring_t* capture_ring;
+#endif
+    int spi_queue_size;
+    max7219_bus_ownership_t bus_ownership;
+    uint32_t bus_idle_release_ms;
+    max7219_hw_config_t hw_config;
+    bool static_storage;
+    bool bus_held;
+    bool bus_used;
+    bool closing;
+    bool in_timer_callback;
     max7219_chain_commands_t commands;
 } led_driver_max7219_context_t;
 
+_Static_assert(sizeof(led_driver_max7219_context_t) <= sizeof(led_driver_max7219_context_storage_t), "LED_DRIVER_MAX7219_CONTEXT_SIZE is too small");
+_Static_assert(_Alignof(led_driver_max7219_context_t) <= _Alignof(led_driver_max7219_context_storage_t), "led_driver_max7219_context_storage_t is not sufficiently aligned");
+
 
 #if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
     #define LOG_NULL_HANDLE() ESP_LOGE(LedDriverMax7219LogTag, "'handle' must not be NULL")
@@ -75,43 +207,119 @@ typedef struct led_driver_max7219_context {
             LOG_NULL_HANDLE(); \
             return ESP_ERR_INVALID_ARG; \
         } \
-        driver_context = __containerof(handle, led_driver_max7219_context_t, api); \
+        driver_context = CONTEXT_FROM_HANDLE(handle); \
     } while(0)
 
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    // One task owns the handle - Calls are direct and the handle points to the context itself
+    #define DRIVER_API(driver_context, function) function##_api
+    #define CONTEXT_FROM_HANDLE(handle) ((led_driver_max7219_context_t*) (handle))
+    #define HANDLE_FROM_CONTEXT(driver_context) ((led_driver_max7219_handle_t) (driver_context))
+#else
+    #define DRIVER_API(driver_context, function) (driver_context)->api.function
+    #define CONTEXT_FROM_HANDLE(handle) __containerof(handle, led_driver_max7219_context_t, api)
+    #define HANDLE_FROM_CONTEXT(driver_context) (&(driver_context)->api)
+#endif
+
+static inline BaseType_t take_driver_mutex_private(led_driver_max7219_context_t* driver_context, TickType_t ticksToWait) {
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    // One task owns the handle - There is nothing to lock
+    return pdTRUE;
+#else
+    return xSemaphoreTake(driver_context->mutex, ticksToWait);
+#endif
+}
+
+static inline BaseType_t give_driver_mutex_private(led_driver_max7219_context_t* driver_context) {
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    return pdTRUE;
+#else
+    return xSemaphoreGive(driver_context->mutex);
+#endif
+}
+
+// Guards 'closing' and 'in_timer_callback' of every driver context
+static portMUX_TYPE TimerCallbacksLock = portMUX_INITIALIZER_UNLOCKED;
+
+
+
+// Operation stage timestamps - Constant 0 without latency tracing so timestamps and recording compile away
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    #define LATENCY_TIMESTAMP() esp_timer_get_time()
+#else
+    #define LATENCY_TIMESTAMP() ((int64_t) 0)
+#endif
+
+// Operation which is not a public driver operation and is never traced, like the initial state sent by `led_driver_max7219_init()`
+#define LATENCY_API_UNTRACED MAX7219_LATENCY_API_COUNT
+
+// Chain transfer timestamps - Used by latency tracing and SPI capture
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING || CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+    #define TRANSFER_TIMESTAMP() esp_timer_get_time()
+#else
+    #define TRANSFER_TIMESTAMP() ((int64_t) 0)
+#endif
 
+// Number of devices on the chain - A compile time constant when CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH is set so loops over devices have a constant trip count
+#ifdef MAX7219_FIXED_CHAIN_LENGTH
+    #define CHAIN_LENGTH(driver_context) ((uint8_t) MAX7219_FIXED_CHAIN_LENGTH)
+#else
+    #define CHAIN_LENGTH(driver_context) ((driver_context)->hw_config.chain_length)
+#endif
 
 static inline __attribute__((always_inline)) max7219_command_t* get_command_buffer_private(led_driver_max7219_context_t* driver_context) {
+#ifdef MAX7219_FIXED_CHAIN_LENGTH
+    return driver_context->commands.commands_data;
+#else
     return driver_context->commands.use_inline_buffer ? driver_context->commands.commands_data : driver_context->commands.commands_buffer;
+#endif
 }
 
 
+static esp_err_t attach_driver_private(const max7219_config_t* config, led_driver_max7219_context_t* driver_context);
 static void free_driver_memory_private(led_driver_max7219_context_t* driver_context);
 
+static inline __attribute__((always_inline)) void invalidate_shown_frame_private(led_driver_max7219_context_t* driver_context) {
+    if (driver_context->frame_buffers != NULL) {
+        driver_context->frame_buffers->shown_valid = false;
+        driver_context->frame_buffers->foreign_writes++;
+    }
+}
+
 static esp_err_t configure_decode_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_decode_mode_t decodeMode);
 static esp_err_t configure_scan_limit_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, uint8_t digits);
 static esp_err_t set_mode_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_mode_t mode);
 static esp_err_t set_intensity_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_intensity_t intensity);
 static esp_err_t set_digits_api(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount);
 
+static esp_err_t set_digits_private(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, TickType_t ticksToWait);
+static esp_err_t set_digits_or_stage_private(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, TickType_t ticksToWait);
+
 
 // ======================================================================= SPI DATA EXCHANGE ======================================================================================
 // Internally, the driver can send to the SPI bus via two methods:
-//  * - Send ONE MAX7219 command to the chain (one device or all devices) via `send_chain_command_private(const chain_command_t*)`
+//  * - Send ONE MAX7219 command to the chain (one device or all devices) via `send_chain_command_private(max7219_latency_api_t, const chain_command_t*)`
 //      The data is sent under an exclusive SPI bus access while holding the driver private SPI access semaphore
 //
-//  * - Send MULTIPLE commands to the chain via `send_chain_with_callback_private(const send_chain_callback_t, void* args)` and a custom callback function
+//  * - Send MULTIPLE commands to the chain via `send_chain_with_callback_private(max7219_latency_api_t, const send_chain_callback_t, void* args)` and a custom callback function
 //      Custom callbacks are invoked under an exclusive SPI bus access while holding the driver private SPI access semaphore
 //      ! To avoid deadlocks, callbacks MUST send via `send_chain_one_command_callback()` and/or `spi_send_private()`
+//
+//  * `send_chain_with_timeout_private(max7219_latency_api_t, TickType_t, const send_chain_callback_t, void* args)` bounds the wait for the driver semaphore and returns ESP_ERR_TIMEOUT without sending
+//      when the driver stays busy. The wait for the SPI bus is not bounded since `spi_device_acquire_bus()` only supports `portMAX_DELAY`
+//
+//  * The `max7219_latency_api_t` argument names the public operation for latency tracing
 
 typedef struct {
     uint8_t chainId;
     max7219_command_t cmd;
 } chain_command_t;
 
-static esp_err_t send_chain_command_private(led_driver_max7219_context_t* driver_context, const chain_command_t* cmd);
+static esp_err_t send_chain_command_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, const chain_command_t* cmd);
 
 typedef esp_err_t (*send_chain_callback_t)(led_driver_max7219_context_t* driver_context, void* args);
-static esp_err_t send_chain_with_callback_private(led_driver_max7219_context_t* driver_context, send_chain_callback_t send_cb, void* args);
+static esp_err_t send_chain_with_callback_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, send_chain_callback_t send_cb, void* args);
+static esp_err_t send_chain_with_timeout_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, TickType_t ticksToWait, send_chain_callback_t send_cb, void* args);
 
 static esp_err_t send_chain_one_command_callback(led_driver_max7219_context_t* driver_context, void* arg);
 
@@ -132,7 +340,78 @@ typedef struct {
 } chain_multiple_digits_t;
 static esp_err_t send_chain_multiple_digits_callback(led_driver_max7219_context_t* driver_context, void* arg);
 
+typedef struct {
+    const uint8_t* digitCodes;
+    uint8_t* pendingDigits;
+} chain_digit_set_t;
+typedef struct {
+    uint8_t startChainId;
+    uint8_t startDigitId;
+    const uint8_t* digitCodes;
+    uint16_t digitCodesCount;
+    const uint8_t* changedDigits;
+} chain_changed_digits_t;
+static esp_err_t send_chain_changed_digits_callback(led_driver_max7219_context_t* driver_context, void* arg);
+
+static esp_err_t send_chain_digit_set_callback(led_driver_max7219_context_t* driver_context, void* arg);
+
+static esp_err_t send_chain_frame_callback(led_driver_max7219_context_t* driver_context, void* arg);
+
+static esp_err_t send_chain_script_callback(led_driver_max7219_context_t* driver_context, void* arg);
+
+typedef struct chain_wire_frames {
+    const uint8_t* const* frames;
+    uint16_t frameCount;
+} chain_wire_frames_t;
+static esp_err_t send_chain_wire_frames_callback(led_driver_max7219_context_t* driver_context, void* arg);
+
+static esp_err_t send_chain_initial_state_callback(led_driver_max7219_context_t* driver_context, void* arg);
+
+static void stage_digit_private(max7219_digit_mailbox_t* mailbox, uint8_t chainId, uint8_t digit, uint8_t digitCode);
+static bool take_mailbox_private(led_driver_max7219_context_t* driver_context, max7219_digit_mailbox_t* mailbox, uint8_t* drainCodes, uint8_t* drainDigits, int64_t* oldestUs);
+static esp_err_t drain_mailbox_private(led_driver_max7219_context_t* driver_context, max7219_digit_mailbox_t* mailbox, max7219_priority_t priority);
+static esp_err_t drain_pending_private(led_driver_max7219_context_t* driver_context);
+static esp_err_t try_drain_pending_private(led_driver_max7219_context_t* driver_context);
+static void record_latency_private(led_driver_max7219_context_t* driver_context, max7219_priority_t priority, int64_t latencyUs);
+
+static esp_err_t finish_operation_private(led_driver_max7219_context_t* driver_context);
+
+static void mirror_commands_private(led_driver_max7219_context_t* driver_context, const max7219_command_t* const data);
+static esp_err_t apply_power_policy_private(led_driver_max7219_context_t* driver_context);
+static esp_err_t send_shutdown_changes_private(led_driver_max7219_context_t* driver_context, const bool shutdown[]);
+static void idle_timer_callback(void* arg);
+static esp_err_t create_power_manager_private(led_driver_max7219_context_t* driver_context);
+static void free_power_manager_private(led_driver_max7219_context_t* driver_context);
+static esp_err_t send_chain_power_policy_off_callback(led_driver_max7219_context_t* driver_context, void* arg);
+
+static bool enter_timer_callback_private(led_driver_max7219_context_t* driver_context);
+static void exit_timer_callback_private(led_driver_max7219_context_t* driver_context);
+static void close_timer_callbacks_private(led_driver_max7219_context_t* driver_context);
+static void delete_timers_private(led_driver_max7219_context_t* driver_context);
+static bool is_mailbox_pending_private(max7219_digit_mailbox_t* mailbox);
+
+static inline __attribute__((always_inline)) bool is_write_combining_private(led_driver_max7219_context_t* driver_context) {
+    return (driver_context->write_combiner != NULL) && (driver_context->write_combiner->window_us != 0);
+}
+static esp_err_t combine_digits_private(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount);
+static esp_err_t drain_write_combiner_private(led_driver_max7219_context_t* driver_context);
+static esp_err_t send_chain_combined_digits_callback(led_driver_max7219_context_t* driver_context, void* arg);
+static void write_combining_timer_callback(void* arg);
+
+static inline void begin_operation_latency_private(led_driver_max7219_context_t* driver_context);
+static inline void record_transmit_latency_private(led_driver_max7219_context_t* driver_context, int64_t transmitUs);
+static inline void record_operation_latency_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, int64_t startUs, int64_t mutexUs, int64_t busUs, int64_t sentUs);
+
+static inline void capture_transfer_private(led_driver_max7219_context_t* driver_context, int64_t startUs, int64_t endUs, const void* data, uint16_t lengthInBytes);
+
+static esp_err_t acquire_bus_private(led_driver_max7219_context_t* driver_context);
+static void release_bus_private(led_driver_max7219_context_t* driver_context);
+static void give_up_bus_private(led_driver_max7219_context_t* driver_context);
+static void bus_release_timer_callback(void* arg);
+
 static esp_err_t spi_send_private(led_driver_max7219_context_t* driver_context, const max7219_command_t* const data, uint16_t commandsCount);
+static esp_err_t spi_send_batch_private(led_driver_max7219_context_t* driver_context, spi_transaction_t* transactions, uint16_t transactionsCount);
+static void record_transfer_private(led_driver_max7219_context_t* driver_context, const max7219_command_t* const data, uint16_t lengthInBytes, int64_t startUs, int64_t endUs);
 // =================================================================================================================================================================================
 
 
@@ -155,6 +434,15 @@ esp_err_t led_driver_max7219_init(const max7219_config_t* config, led_driver_max
     // Check configuration
     ESP_RETURN_ON_ERROR(check_driver_configuration_private(config), LedDriverMax7219LogTag, "Invalid configuration");
 
+#ifdef MAX7219_FIXED_CHAIN_LENGTH
+    // Allocate space for our handle - The command buffer is part of the context and is sent via DMA
+    led_driver_max7219_context_t* pLedMax7219 = heap_caps_calloc(1, sizeof(led_driver_max7219_context_t), MALLOC_CAP_DMA);
+    if (pLedMax7219 == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+#else
     // Allocate space for our handle
     led_driver_max7219_context_t* pLedMax7219 = heap_caps_calloc(1, sizeof(led_driver_max7219_context_t), MALLOC_CAP_DEFAULT);
     if (pLedMax7219 == NULL) {
@@ -168,11 +456,73 @@ esp_err_t led_driver_max7219_init(const max7219_config_t* config, led_driver_max
         pLedMax7219->commands.commands_buffer = heap_caps_calloc(config->hw_config.chain_length, sizeof(max7219_command_t), MALLOC_CAP_DMA);
         ESP_GOTO_ON_FALSE(pLedMax7219->commands.commands_buffer != NULL, ESP_ERR_NO_MEM, cleanup, LedDriverMax7219LogTag, "Could not allocate memory for command buffer");
     }
+#endif
 
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
     // Initialize mutex for multithreading protection
     pLedMax7219->mutex = xSemaphoreCreateMutexWithCaps(MALLOC_CAP_DEFAULT);
     ESP_GOTO_ON_FALSE(pLedMax7219->mutex != NULL, ESP_ERR_NO_MEM, cleanup, LedDriverMax7219LogTag, "Could not allocate memory for mutex");
+#endif
+
+    ESP_GOTO_ON_ERROR(attach_driver_private(config, pLedMax7219), cleanup, LedDriverMax7219LogTag, "Failed to attach driver");
+
+    *handle = HANDLE_FROM_CONTEXT(pLedMax7219);
+
+    return ret;
+
+cleanup:
+    free_driver_memory_private(pLedMax7219);
+    return ret;
+}
+
+esp_err_t led_driver_max7219_init_static(const max7219_config_t* config, const max7219_static_buffers_t* buffers, led_driver_max7219_handle_t* handle) {
+    if (handle == NULL) {
+        LOG_NULL_HANDLE();
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Always clear return values even if we later fail
+    *handle = NULL;
+
+    // Check configuration and caller provided storage
+    ESP_RETURN_ON_ERROR(check_driver_configuration_private(config), LedDriverMax7219LogTag, "Invalid configuration");
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    ESP_RETURN_ON_FALSE((buffers != NULL) && (buffers->context != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'buffers' and 'buffers->context' must not be NULL");
+#else
+    ESP_RETURN_ON_FALSE((buffers != NULL) && (buffers->context != NULL) && (buffers->mutex != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'buffers', 'buffers->context' and 'buffers->mutex' must not be NULL");
+#endif
+
+    led_driver_max7219_context_t* pLedMax7219 = (led_driver_max7219_context_t*) buffers->context;
+    memset(pLedMax7219, 0, sizeof(led_driver_max7219_context_t));
+    pLedMax7219->static_storage = true;
+
+#ifndef MAX7219_FIXED_CHAIN_LENGTH
+    // Use the caller provided DMA buffer if the command buffer cannot fit in spi_transaction_t.tx_data which is a uint8_t[4]
+    pLedMax7219->commands.use_inline_buffer = config->hw_config.chain_length * sizeof(max7219_command_t) <= sizeof(uint8_t[4]);
+    if (!pLedMax7219->commands.use_inline_buffer) {
+        ESP_RETURN_ON_FALSE((buffers->dma_buffer != NULL) && (buffers->dma_buffer_size >= LED_DRIVER_MAX7219_DMA_BUFFER_SIZE(config->hw_config.chain_length)), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'buffers->dma_buffer' must hold at least LED_DRIVER_MAX7219_DMA_BUFFER_SIZE(chain_length) bytes");
+        pLedMax7219->commands.commands_buffer = (max7219_command_t*) buffers->dma_buffer;
+    }
+#endif
+
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
+    // Initialize mutex for multithreading protection - Cannot fail when given a buffer
+    pLedMax7219->mutex = xSemaphoreCreateMutexStatic(buffers->mutex);
+#endif
+
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_ERROR(attach_driver_private(config, pLedMax7219), cleanup, LedDriverMax7219LogTag, "Failed to attach driver");
+
+    *handle = HANDLE_FROM_CONTEXT(pLedMax7219);
+
+    return ret;
+
+cleanup:
+    free_driver_memory_private(pLedMax7219);
+    return ret;
+}
 
+static esp_err_t attach_driver_private(const max7219_config_t* config, led_driver_max7219_context_t* driver_context) {
     // Add an SPI device on the given bus - We accept the SPI bus configuration as is
     spi_device_interface_config_t spiDeviceInterfaceConfig = {
         .command_bits = 0,
@@ -197,23 +547,116 @@ esp_err_t led_driver_max7219_init(const max7219_config_t* config, led_driver_max
         .queue_size = config->spi_cfg.queue_size
     };
 
-    ESP_GOTO_ON_ERROR(spi_bus_add_device(config->spi_cfg.host_id, &spiDeviceInterfaceConfig, &pLedMax7219->spi_device_handle), cleanup, LedDriverMax7219LogTag, "Failed to spi_bus_add_device()");
+    ESP_RETURN_ON_ERROR(spi_bus_add_device(config->spi_cfg.host_id, &spiDeviceInterfaceConfig, &driver_context->spi_device_handle), LedDriverMax7219LogTag, "Failed to spi_bus_add_device()");
     
-    pLedMax7219->hw_config = config->hw_config;
+    driver_context->hw_config = config->hw_config;
+    driver_context->spi_queue_size = config->spi_cfg.queue_size;
+    driver_context->bus_ownership = config->spi_cfg.bus_ownership;
+    driver_context->bus_idle_release_ms = config->spi_cfg.bus_idle_release_ms;
+
+    // Apply the SPI bus ownership policy - The device is removed from the bus on failure since the caller never receives a handle
+    esp_err_t err = ESP_OK;
+    if (driver_context->bus_ownership == MAX7219_BUS_OWNERSHIP_PERSISTENT) {
+        err = acquire_bus_private(driver_context);
+    } else if (driver_context->bus_ownership == MAX7219_BUS_OWNERSHIP_IDLE_RELEASE) {
+        esp_timer_create_args_t timerArgs = {
+            .callback = bus_release_timer_callback,
+            .arg = driver_context,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "max7219_bus",
+            .skip_unhandled_events = true
+        };
+        err = esp_timer_create(&timerArgs, &driver_context->bus_release_timer);
+    }
+    if (err != ESP_OK) {
+#if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
+        ESP_LOGE(LedDriverMax7219LogTag, "Failed to apply the SPI bus ownership policy (%d)", err);
+#endif
+        spi_bus_remove_device(driver_context->spi_device_handle);
+        driver_context->spi_device_handle = NULL;
+        return err;
+    }
 
-    pLedMax7219->api.configure_decode = configure_decode_api;
-    pLedMax7219->api.configure_scan_limit = configure_scan_limit_api;
-    pLedMax7219->api.set_mode = set_mode_api;
-    pLedMax7219->api.set_intensity = set_intensity_api;
-    pLedMax7219->api.set_digits = set_digits_api;
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
+    driver_context->api.configure_decode = configure_decode_api;
+    driver_context->api.configure_scan_limit = configure_scan_limit_api;
+    driver_context->api.set_mode = set_mode_api;
+    driver_context->api.set_intensity = set_intensity_api;
+    driver_context->api.set_digits = set_digits_api;
+#endif
 
-    *handle = &pLedMax7219->api;
+    // Apply the initial state - The device is removed from the bus on failure since the caller never receives a handle
+    if (config->initial_state.apply) {
+        esp_err_t ret = send_chain_with_callback_private(driver_context, LATENCY_API_UNTRACED, send_chain_initial_state_callback, (void*) &config->initial_state);
+        if (ret != ESP_OK) {
+#if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
+            ESP_LOGE(LedDriverMax7219LogTag, "Failed to apply initial state (%d)", ret);
+#endif
+            close_timer_callbacks_private(driver_context);
+            give_up_bus_private(driver_context);
+            spi_bus_remove_device(driver_context->spi_device_handle);
+            driver_context->spi_device_handle = NULL;
+            return ret;
+        }
+    }
 
-    return ret;
+    return ESP_OK;
+}
 
-cleanup:
-    free_driver_memory_private(pLedMax7219);
-    return ret;
+static max7219_command_t initial_state_command_private(const max7219_device_state_t* state, uint8_t frameIndex, uint8_t lastFrameIndex) {
+    if (frameIndex == lastFrameIndex) {
+        // Test mode overrides shutdown mode - A device entering test mode stays in shutdown mode underneath
+        return state->mode == MAX7219_TEST_MODE ? (max7219_command_t) { .address = MAX7219_TEST_ADDRESS, .data = 1 } :
+                                                  (max7219_command_t) { .address = MAX7219_SHUTDOWN_ADDRESS, .data = state->mode == MAX7219_NORMAL_MODE ? 1 : 0 };
+    }
+
+    switch (frameIndex) {
+        case 0:
+            // Leave test mode, if on after a restart without power cycle
+            return (max7219_command_t) { .address = MAX7219_TEST_ADDRESS, .data = 0 };
+        case 1:
+            // Configure in shutdown mode so nothing shows until the device is fully configured
+            return (max7219_command_t) { .address = MAX7219_SHUTDOWN_ADDRESS, .data = 0 };
+        case 2:
+            return (max7219_command_t) { .address = MAX7219_SCAN_LIMIT_ADDRESS, .data = state->scan_limit - 1 };
+        case 3:
+            return (max7219_command_t) { .address = MAX7219_DECODE_MODE_ADDRESS, .data = state->decode };
+        case 4:
+            return (max7219_command_t) { .address = MAX7219_INTENSITY_ADDRESS, .data = state->intensity };
+        default: {
+            // Digits past the scan limit are not displayed - Devices scanning fewer digits than others skip the remaining transfers
+            uint8_t digitIndex = frameIndex - 5;
+            if (digitIndex >= state->scan_limit) {
+                return (max7219_command_t) { .address = MAX7219_NOOP_ADDRESS, .data = 0 };
+            }
+
+            uint8_t blank = (state->decode & (1 << digitIndex)) != 0 ? MAX7219_CODE_B_BLANK : MAX7219_DIRECT_ADDRESSING_BLANK;
+            return (max7219_command_t) { .address = MAX7219_DIGIT0_ADDRESS + digitIndex, .data = state->digits != NULL ? state->digits[digitIndex] : blank };
+        }
+    }
+}
+
+static esp_err_t send_chain_initial_state_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    const max7219_initial_state_t* initialState = (const max7219_initial_state_t*) arg;
+
+    // One transfer per register: test, shutdown, scan limit, decode, intensity, digits up to the largest scan limit and finally mode
+    uint8_t digitFrames = 0;
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        const max7219_device_state_t* state = initialState->devices != NULL ? &initialState->devices[chainIndex] : &initialState->chain;
+        digitFrames = state->scan_limit > digitFrames ? state->scan_limit : digitFrames;
+    }
+
+    max7219_command_t* buffer = get_command_buffer_private(driver_context);
+    const uint8_t lastFrameIndex = 5 + digitFrames;
+    for (uint8_t frameIndex = 0; frameIndex <= lastFrameIndex; frameIndex++) {
+        for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+            const max7219_device_state_t* state = initialState->devices != NULL ? &initialState->devices[chainIndex] : &initialState->chain;
+            buffer[CHAIN_LENGTH(driver_context) - 1 - chainIndex] = initial_state_command_private(state, frameIndex, lastFrameIndex);
+        }
+        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context)), LedDriverMax7219LogTag, "Failed to send commands to chain");
+    }
+
+    return ESP_OK;
 }
 
 esp_err_t led_driver_max7219_free(led_driver_max7219_handle_t handle) {
@@ -230,6 +673,9 @@ esp_err_t led_driver_max7219_free(led_driver_max7219_handle_t handle) {
     // Track the first error we encounter so we can return it to the caller - We do try to detach all aspects of the driver regardless of which step failed
     esp_err_t firstError = ESP_OK;
 
+    // Timer callbacks in flight complete first and later ones return right away, without touching the driver
+    close_timer_callbacks_private(driver_context);
+
     // Put all MAX7219 / MAX7221 cascaded on the chain in shutdown mode before freeing the driver
     // NOTE: We use the public facing, error detecting API here on purpose to protect against invalid handles
     esp_err_t err = led_driver_max7219_set_chain_mode(handle, MAX7219_SHUTDOWN_MODE);
@@ -238,6 +684,22 @@ esp_err_t led_driver_max7219_free(led_driver_max7219_handle_t handle) {
         ESP_LOGW(LedDriverMax7219LogTag, "Failed to set MAX7219/MAX7221 in shutdown mode (%d)", err);
     }
 
+    // Wait for transfers still queued by a bus coordinator - The device cannot be removed while it has transfers in flight
+    err = led_driver_max7219_detach_bus_coordinator(handle);
+    if (err != ESP_OK) {
+        firstError = firstError == ESP_OK ? err : firstError;
+        ESP_LOGW(LedDriverMax7219LogTag, "Failed to detach MAX7219/MAX7221 from bus coordinator (%d)", err);
+    }
+
+    // Timers are deleted under the driver mutex so no operation can re-arm them while they go away
+    if (take_driver_mutex_private(driver_context, portMAX_DELAY) == pdTRUE) {
+        delete_timers_private(driver_context);
+        give_driver_mutex_private(driver_context);
+    }
+
+    // Release the SPI bus if the ownership policy kept it - The device cannot be removed while it holds the bus
+    give_up_bus_private(driver_context);
+
     // Remove the device from the bus
     err = spi_bus_remove_device(driver_context->spi_device_handle);
     if (err != ESP_OK) {
@@ -252,19 +714,69 @@ esp_err_t led_driver_max7219_free(led_driver_max7219_handle_t handle) {
 
 static void free_driver_memory_private(led_driver_max7219_context_t* driver_context) {
     if (driver_context != NULL) {
+        if (driver_context->frame_buffers != NULL) {
+            heap_caps_free(driver_context->frame_buffers);
+            driver_context->frame_buffers = NULL;
+        }
+
+        if (driver_context->priority_classes != NULL) {
+            heap_caps_free(driver_context->priority_classes);
+            driver_context->priority_classes = NULL;
+        }
+
+        free_power_manager_private(driver_context);
+
+        if (driver_context->write_combiner != NULL) {
+            if (driver_context->write_combiner->window_timer != NULL) {
+                esp_timer_stop(driver_context->write_combiner->window_timer);
+                esp_timer_delete(driver_context->write_combiner->window_timer);
+            }
+            heap_caps_free(driver_context->write_combiner);
+            driver_context->write_combiner = NULL;
+        }
+
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+        if (driver_context->latency_tracer != NULL) {
+            heap_caps_free(driver_context->latency_tracer);
+            driver_context->latency_tracer = NULL;
+        }
+#endif
+
+#if CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+        if (driver_context->capture_ring != NULL) {
+            heap_caps_free(driver_context->capture_ring);
+            driver_context->capture_ring = NULL;
+        }
+#endif
+
+        // Storage provided to led_driver_max7219_init_static() belongs to the caller - Invalidate the context so stale handles are rejected
+        if (driver_context->static_storage) {
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
+            if (driver_context->mutex != NULL) {
+                vSemaphoreDelete(driver_context->mutex);
+            }
+#endif
+            memset(driver_context, 0, sizeof(led_driver_max7219_context_t));
+            return;
+        }
+
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
         if (driver_context->mutex != NULL) {
             vSemaphoreDeleteWithCaps(driver_context->mutex);
             driver_context->mutex = NULL;
         }
+#endif
 
+#ifndef MAX7219_FIXED_CHAIN_LENGTH
         if (!driver_context->commands.use_inline_buffer && (driver_context->commands.commands_buffer != NULL)) {
             heap_caps_free(driver_context->commands.commands_buffer);
             driver_context->commands.commands_buffer = NULL;
         }
+#endif
         
         heap_caps_free(driver_context);
     }
-} 
+}
 
 
 esp_err_t led_driver_max7219_configure_chain_decode(led_driver_max7219_handle_t handle, max7219_decode_mode_t decodeMode) {
@@ -272,7 +784,7 @@ esp_err_t led_driver_max7219_configure_chain_decode(led_driver_max7219_handle_t
     ACQUIRE_CONTEXT_OR_RETURN(handle);
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
 
-    return driver_context->api.configure_decode(driver_context, 0, decodeMode);
+    return DRIVER_API(driver_context, configure_decode)(driver_context, 0, decodeMode);
 }
 
 esp_err_t led_driver_max7219_configure_decode(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_decode_mode_t decodeMode) {
@@ -281,13 +793,13 @@ esp_err_t led_driver_max7219_configure_decode(led_driver_max7219_handle_t handle
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
     ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
 
-    return driver_context->api.configure_decode(driver_context, chainId, decodeMode);
+    return DRIVER_API(driver_context, configure_decode)(driver_context, chainId, decodeMode);
 }
 
 static esp_err_t configure_decode_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_decode_mode_t decodeMode) {
     // Send |MAX7219_DECODE_MODE_ADDRESS|<mode>| to the requested device or all devices (chainId == 0)
     chain_command_t chain_command = {.chainId = chainId, .cmd = { .address = MAX7219_DECODE_MODE_ADDRESS, .data = decodeMode }};
-    return send_chain_command_private(driver_context, &chain_command);
+    return send_chain_command_private(driver_context, MAX7219_LATENCY_API_CONFIGURE_DECODE, &chain_command);
 }
 
 
@@ -297,7 +809,7 @@ esp_err_t led_driver_max7219_configure_chain_scan_limit(led_driver_max7219_handl
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
     ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, digits), LedDriverMax7219LogTag, "Invalid digits");
 
-    return driver_context->api.configure_scan_limit(driver_context, 0, digits);
+    return DRIVER_API(driver_context, configure_scan_limit)(driver_context, 0, digits);
 }
 
 esp_err_t led_driver_max7219_configure_scan_limit(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digits) {
@@ -307,13 +819,13 @@ esp_err_t led_driver_max7219_configure_scan_limit(led_driver_max7219_handle_t ha
     ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
     ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, digits), LedDriverMax7219LogTag, "Invalid digits");
 
-    return driver_context->api.configure_scan_limit(driver_context, chainId, digits);
+    return DRIVER_API(driver_context, configure_scan_limit)(driver_context, chainId, digits);
 }
 
 static esp_err_t configure_scan_limit_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, uint8_t digits) {
     // Send |MAX7219_SCAN_LIMIT_ADDRESS|<digits - 1>| to the requested device or all devices (chainId == 0)
     chain_command_t chain_command = {.chainId = chainId, .cmd = { .address = MAX7219_SCAN_LIMIT_ADDRESS, .data = digits - 1 }};
-    return send_chain_command_private(driver_context, &chain_command);
+    return send_chain_command_private(driver_context, MAX7219_LATENCY_API_CONFIGURE_SCAN_LIMIT, &chain_command);
 }
 
 
@@ -322,7 +834,7 @@ esp_err_t led_driver_max7219_set_chain_mode(led_driver_max7219_handle_t handle,
     ACQUIRE_CONTEXT_OR_RETURN(handle);
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
 
-    return driver_context->api.set_mode(driver_context, 0, mode);
+    return DRIVER_API(driver_context, set_mode)(driver_context, 0, mode);
 }
 
 esp_err_t led_driver_max7219_set_mode(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_mode_t mode) {
@@ -331,7 +843,7 @@ esp_err_t led_driver_max7219_set_mode(led_driver_max7219_handle_t handle, uint8_
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
     ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
 
-    return driver_context->api.set_mode(driver_context, chainId, mode);
+    return DRIVER_API(driver_context, set_mode)(driver_context, chainId, mode);
 }
 
 static esp_err_t set_mode_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_mode_t mode) {
@@ -348,14 +860,14 @@ static esp_err_t set_mode_api(led_driver_max7219_context_t* driver_context, uint
                     { .address = MAX7219_SHUTDOWN_ADDRESS, .data = mode == MAX7219_SHUTDOWN_MODE ? 0 : 1 }
                 }
             };
-            return send_chain_with_callback_private(driver_context, send_chain_command_array_callback, &cmd_array);
+            return send_chain_with_callback_private(driver_context, MAX7219_LATENCY_API_SET_MODE, send_chain_command_array_callback, &cmd_array);
         }
         break;
 
         case MAX7219_TEST_MODE: {
             // Send |MAX7219_TEST_ADDRESS|1| to all devices or the target device
             chain_command_t chain_command = {.chainId = chainId, .cmd = { .address = MAX7219_TEST_ADDRESS, .data = 1 }};
-            return send_chain_command_private(driver_context, &chain_command);
+            return send_chain_command_private(driver_context, MAX7219_LATENCY_API_SET_MODE, &chain_command);
         }
         break;
 
@@ -370,7 +882,7 @@ esp_err_t led_driver_max7219_set_chain_intensity(led_driver_max7219_handle_t han
     ACQUIRE_CONTEXT_OR_RETURN(handle);
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
 
-    return driver_context->api.set_intensity(driver_context, 0, intensity);
+    return DRIVER_API(driver_context, set_intensity)(driver_context, 0, intensity);
 }
 
 esp_err_t led_driver_max7219_set_intensity(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_intensity_t intensity) {
@@ -379,13 +891,27 @@ esp_err_t led_driver_max7219_set_intensity(led_driver_max7219_handle_t handle, u
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
     ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
 
-    return driver_context->api.set_intensity(driver_context, chainId, intensity);
+    return DRIVER_API(driver_context, set_intensity)(driver_context, chainId, intensity);
+}
+
+esp_err_t led_driver_max7219_set_intensity_timeout(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_intensity_t intensity, TickType_t ticksToWait) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
+
+    chain_command_t chain_command = {.chainId = chainId, .cmd = { .address = MAX7219_INTENSITY_ADDRESS, .data = intensity }};
+    return send_chain_with_timeout_private(driver_context, MAX7219_LATENCY_API_SET_INTENSITY, ticksToWait, send_chain_one_command_callback, (void*) &chain_command);
+}
+
+esp_err_t led_driver_max7219_try_set_intensity(led_driver_max7219_handle_t handle, uint8_t chainId, max7219_intensity_t intensity) {
+    return led_driver_max7219_set_intensity_timeout(handle, chainId, intensity, 0);
 }
 
 static esp_err_t set_intensity_api(led_driver_max7219_context_t* driver_context, uint8_t chainId, max7219_intensity_t intensity) {
     // Send |MAX7219_INTENSITY_ADDRESS|<intensity>| to the requested device or all devices (chainId == 0)
     chain_command_t chain_command = {.chainId = chainId, .cmd = { .address = MAX7219_INTENSITY_ADDRESS, .data = intensity }};
-    return send_chain_command_private(driver_context, &chain_command);
+    return send_chain_command_private(driver_context, MAX7219_LATENCY_API_SET_INTENSITY, &chain_command);
 }
 
 
@@ -394,7 +920,7 @@ esp_err_t led_driver_max7219_set_chain_digit(led_driver_max7219_handle_t handle,
     ACQUIRE_CONTEXT_OR_RETURN(handle);
     ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
 
-    return driver_context->api.set_digits(driver_context, 0, 0, &digitCode, 1);
+    return DRIVER_API(driver_context, set_digits)(driver_context, 0, 0, &digitCode, 1);
 }
 
 esp_err_t led_driver_max7219_set_digit(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode) {
@@ -404,7 +930,7 @@ esp_err_t led_driver_max7219_set_digit(led_driver_max7219_handle_t handle, uint8
     ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
     ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, digit), LedDriverMax7219LogTag, "Invalid digit");
 
-    return driver_context->api.set_digits(driver_context, chainId, digit, &digitCode, 1);
+    return DRIVER_API(driver_context, set_digits)(driver_context, chainId, digit, &digitCode, 1);
 }
 
 esp_err_t led_driver_max7219_set_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount) {
@@ -415,19 +941,97 @@ esp_err_t led_driver_max7219_set_digits(led_driver_max7219_handle_t handle, uint
     ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, startDigitId), LedDriverMax7219LogTag, "Invalid start digit");
     ESP_RETURN_ON_ERROR(check_bulk_symbols_array_length(driver_context, startChainId, startDigitId, digitCodesCount), LedDriverMax7219LogTag, "Invalid number of digit codes provided");
 
-    return driver_context->api.set_digits(driver_context, startChainId, startDigitId, digitCodes, digitCodesCount);
+    return DRIVER_API(driver_context, set_digits)(driver_context, startChainId, startDigitId, digitCodes, digitCodesCount);
+}
+
+esp_err_t led_driver_max7219_set_digit_timeout(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode, TickType_t ticksToWait) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
+    ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, digit), LedDriverMax7219LogTag, "Invalid digit");
+
+    return set_digits_or_stage_private(driver_context, chainId, digit, &digitCode, 1, ticksToWait);
+}
+
+esp_err_t led_driver_max7219_try_set_digit(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode) {
+    return led_driver_max7219_set_digit_timeout(handle, chainId, digit, digitCode, 0);
+}
+
+esp_err_t led_driver_max7219_set_digits_timeout(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, TickType_t ticksToWait) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, startChainId), LedDriverMax7219LogTag, "Invalid chain ID");
+    ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, startDigitId), LedDriverMax7219LogTag, "Invalid start digit");
+    ESP_RETURN_ON_ERROR(check_bulk_symbols_array_length(driver_context, startChainId, startDigitId, digitCodesCount), LedDriverMax7219LogTag, "Invalid number of digit codes provided");
+
+    return set_digits_or_stage_private(driver_context, startChainId, startDigitId, digitCodes, digitCodesCount, ticksToWait);
+}
+
+esp_err_t led_driver_max7219_try_set_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount) {
+    return led_driver_max7219_set_digits_timeout(handle, startChainId, startDigitId, digitCodes, digitCodesCount, 0);
+}
+
+static esp_err_t set_digits_or_stage_private(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, TickType_t ticksToWait) {
+    esp_err_t err = set_digits_private(driver_context, startChainId, startDigitId, digitCodes, digitCodesCount, ticksToWait);
+    max7219_priority_classes_t* priority_classes = driver_context->priority_classes;
+    if ((err != ESP_ERR_TIMEOUT) || (priority_classes == NULL)) {
+        return err;
+    }
+
+    // The driver stayed busy - Leave the digits in the background mailbox so the task owning the driver sends them when its operation completes
+    uint8_t chainId = startChainId;
+    uint8_t digit = startDigitId;
+    for (uint16_t index = 0; index < digitCodesCount; index++) {
+        stage_digit_private(&priority_classes->background, chainId, digit, digitCodes[index]);
+        if (++digit > MAX7219_MAX_DIGIT) {
+            digit = MAX7219_MIN_DIGIT;
+            chainId++;
+        }
+    }
+
+    // The driver may have become idle meanwhile - The digits are only still staged if the drain left the background mailbox pending
+    ESP_RETURN_ON_ERROR(try_drain_pending_private(driver_context), LedDriverMax7219LogTag, "Failed to send staged digits");
+    return is_mailbox_pending_private(&priority_classes->background) ? ESP_ERR_NOT_FINISHED : ESP_OK;
+}
+
+esp_err_t led_driver_max7219_set_digit_unchecked(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode) {
+    // NOTE: No validation and no dispatch through 'api' on purpose - The caller guarantees all arguments are valid
+    led_driver_max7219_context_t* driver_context = CONTEXT_FROM_HANDLE(handle);
+    if (is_write_combining_private(driver_context)) {
+        return combine_digits_private(driver_context, chainId, digit, &digitCode, 1);
+    }
+
+    chain_command_t chain_command = {.chainId = chainId, .cmd = { .address = digit, .data = digitCode }};
+    return send_chain_command_private(driver_context, MAX7219_LATENCY_API_SET_DIGITS, &chain_command);
+}
+
+esp_err_t led_driver_max7219_set_digits_unchecked(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount) {
+    // NOTE: No validation and no dispatch through 'api' on purpose - The caller guarantees all arguments are valid
+    led_driver_max7219_context_t* driver_context = CONTEXT_FROM_HANDLE(handle);
+    return set_digits_api(driver_context, startChainId, startDigitId, digitCodes, digitCodesCount);
 }
 
 static esp_err_t set_digits_api(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount) {
+    return set_digits_private(driver_context, startChainId, startDigitId, digitCodes, digitCodesCount, portMAX_DELAY);
+}
+
+static esp_err_t set_digits_private(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, TickType_t ticksToWait) {
+    // Digits are staged until the write combining window closes
+    if (is_write_combining_private(driver_context)) {
+        return combine_digits_private(driver_context, startChainId, startDigitId, digitCodes, digitCodesCount);
+    }
+
     // Optimization for one digit sent to the entire chain (startChainId == 0, startDigitId == 0)
     if ((startChainId == 0) && (startDigitId == 0) && (digitCodesCount == 1)) {
-        return send_chain_with_callback_private(driver_context, send_chain_single_digit_callback, (void*) (uintptr_t) digitCodes[0]);
+        return send_chain_with_timeout_private(driver_context, MAX7219_LATENCY_API_SET_DIGITS, ticksToWait, send_chain_single_digit_callback, (void*) (uintptr_t) digitCodes[0]);
     } else {
         // Optimization for one digit at one position in the chain - Use the SPI transaction data buffer directly and avoid the overhead of copying data to the command buffer
         if (digitCodesCount == 1) {
             // Send |MAX7219_DIGIT<digit>_ADDRESS|<digitCode>| to the requested device
             chain_command_t chain_command = {.chainId = startChainId, .cmd = { .address = startDigitId, .data = digitCodes[0] }};
-            return send_chain_command_private(driver_context, &chain_command);
+            return send_chain_with_timeout_private(driver_context, MAX7219_LATENCY_API_SET_DIGITS, ticksToWait, send_chain_one_command_callback, (void*) &chain_command);
         } else {
             // All other cases - With multiple digits to send we need to send multiple commands to the chain, one for each digit
             chain_multiple_digits_t multiple_digits = {
@@ -436,23 +1040,51 @@ static esp_err_t set_digits_api(led_driver_max7219_context_t* driver_context, ui
                 .digitCodes = digitCodes,
                 .digitCodesCount = digitCodesCount
             };
-            return send_chain_with_callback_private(driver_context, send_chain_multiple_digits_callback, (void*) &multiple_digits);
+            return send_chain_with_timeout_private(driver_context, MAX7219_LATENCY_API_SET_DIGITS, ticksToWait, send_chain_multiple_digits_callback, (void*) &multiple_digits);
         }
     }
 }
 
+esp_err_t led_driver_max7219_set_changed_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, const uint8_t changedDigits[]) {
+    return led_driver_max7219_set_changed_digits_timeout(handle, startChainId, startDigitId, digitCodes, digitCodesCount, changedDigits, portMAX_DELAY);
+}
+
+esp_err_t led_driver_max7219_set_changed_digits_timeout(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, const uint8_t changedDigits[], TickType_t ticksToWait) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, startChainId), LedDriverMax7219LogTag, "Invalid chain ID");
+    ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, startDigitId), LedDriverMax7219LogTag, "Invalid start digit");
+    ESP_RETURN_ON_ERROR(check_bulk_symbols_array_length(driver_context, startChainId, startDigitId, digitCodesCount), LedDriverMax7219LogTag, "Invalid number of digit codes provided");
+    ESP_RETURN_ON_FALSE((digitCodes != NULL) && (changedDigits != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'digitCodes' and 'changedDigits' must not be NULL");
+
+    chain_changed_digits_t changed_digits = {
+        .startChainId = startChainId,
+        .startDigitId = startDigitId,
+        .digitCodes = digitCodes,
+        .digitCodesCount = digitCodesCount,
+        .changedDigits = changedDigits
+    };
+    return send_chain_with_timeout_private(driver_context, MAX7219_LATENCY_API_SET_DIGITS, ticksToWait, send_chain_changed_digits_callback, (void*) &changed_digits);
+}
+
+esp_err_t led_driver_max7219_try_set_changed_digits(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount, const uint8_t changedDigits[]) {
+    return led_driver_max7219_set_changed_digits_timeout(handle, startChainId, startDigitId, digitCodes, digitCodesCount, changedDigits, 0);
+}
+
 static esp_err_t send_chain_single_digit_callback(led_driver_max7219_context_t* driver_context, void* arg) {
     uint8_t digitCode = (uint8_t)(uintptr_t)arg;
+    invalidate_shown_frame_private(driver_context);
 
     // Send |MAX7219_DIGIT<digit>_ADDRESS|<digitCode>| to all devices
     // NOTE: We first clear digit 1 on all devices, then digit 2 on all devices and so on
     max7219_command_t* buffer = get_command_buffer_private(driver_context);
     for (uint8_t digit = MAX7219_MIN_DIGIT; digit <= MAX7219_MAX_DIGIT; digit++) {
         max7219_command_t command = { .address = digit, .data = digitCode };
-        for (uint8_t deviceIndex = 0; deviceIndex < driver_context->hw_config.chain_length; deviceIndex++) {
+        for (uint8_t deviceIndex = 0; deviceIndex < CHAIN_LENGTH(driver_context); deviceIndex++) {
             buffer[deviceIndex] = command;
         }
-        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, driver_context->hw_config.chain_length), LedDriverMax7219LogTag, "Failed to send commands to chain");
+        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context)), LedDriverMax7219LogTag, "Failed to send commands to chain");
     }
 
     return ESP_OK;
@@ -461,17 +1093,18 @@ static esp_err_t send_chain_single_digit_callback(led_driver_max7219_context_t*
 static esp_err_t send_chain_multiple_digits_callback(led_driver_max7219_context_t* driver_context, void* arg) {
     chain_multiple_digits_t* chain_digits = (chain_multiple_digits_t*)arg;
     max7219_command_t* buffer = get_command_buffer_private(driver_context);
+    invalidate_shown_frame_private(driver_context);
     
     uint8_t dstDigitIndex = chain_digits->startDigitId;
-    uint8_t deviceIndex = driver_context->hw_config.chain_length -  chain_digits->startChainId;
+    uint8_t deviceIndex = CHAIN_LENGTH(driver_context) -  chain_digits->startChainId;
 
     for (uint16_t srcDigitIndex = 0; srcDigitIndex < chain_digits->digitCodesCount; srcDigitIndex++) {
         // Send |MAX7219_DIGIT<digit>_ADDRESS|<digitCode>| to the correct device in the chain 
-        memset(buffer, 0, driver_context->hw_config.chain_length * sizeof(max7219_command_t));
+        memset(buffer, 0, CHAIN_LENGTH(driver_context) * sizeof(max7219_command_t));
         max7219_command_t command = { .address = dstDigitIndex, .data = chain_digits->digitCodes[srcDigitIndex] };
         buffer[deviceIndex] = command;
 
-        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, driver_context->hw_config.chain_length), LedDriverMax7219LogTag, "Failed to send commands to chain");
+        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context)), LedDriverMax7219LogTag, "Failed to send commands to chain");
 
         dstDigitIndex++;
         if (dstDigitIndex > MAX7219_MAX_DIGIT) {
@@ -485,34 +1118,1301 @@ static esp_err_t send_chain_multiple_digits_callback(led_driver_max7219_context_
 
 
 
-static esp_err_t send_chain_command_private(led_driver_max7219_context_t* driver_context, const chain_command_t* cmd) {
-    return send_chain_with_callback_private(driver_context, send_chain_one_command_callback, (void*)cmd);
+static uint8_t changed_digits_mask_private(const chain_changed_digits_t* changed_digits, uint16_t firstIndex, uint8_t chainIndex) {
+    // Bit (digit - 1) is set for each flagged digit of device 'chainIndex + 1' within the range
+    uint8_t digitsMask = 0;
+    for (uint8_t digitIndex = 0; digitIndex < MAX7219_MAX_DIGIT; digitIndex++) {
+        uint16_t frameIndex = chainIndex * MAX7219_MAX_DIGIT + digitIndex;
+        if ((frameIndex >= firstIndex) && (frameIndex - firstIndex < changed_digits->digitCodesCount)) {
+            uint16_t codeIndex = frameIndex - firstIndex;
+            digitsMask |= ((changed_digits->changedDigits[codeIndex / 8] >> (codeIndex % 8)) & 1) << digitIndex;
+        }
+    }
+    return digitsMask;
 }
 
-static esp_err_t send_chain_with_callback_private(led_driver_max7219_context_t* driver_context, send_chain_callback_t send_cb, void* args) {
-    ESP_RETURN_ON_FALSE(xSemaphoreTake(driver_context->mutex, portMAX_DELAY) == pdTRUE, ESP_ERR_TIMEOUT, LedDriverMax7219LogTag, "Could not acquire mutex");
+static esp_err_t send_chain_changed_digits_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    chain_changed_digits_t* changed_digits = (chain_changed_digits_t*)arg;
+    max7219_command_t* buffer = get_command_buffer_private(driver_context);
+    invalidate_shown_frame_private(driver_context);
+
+    const uint16_t firstIndex = MAX7219_FRAME_INDEX(changed_digits->startChainId, changed_digits->startDigitId);
+    const uint8_t firstChainIndex = changed_digits->startChainId - 1;
+    const uint8_t lastChainIndex = (firstIndex + changed_digits->digitCodesCount - 1) / MAX7219_MAX_DIGIT;
+
+    // Chain frame 'frameIndex' sends the flagged digit of rank 'frameIndex' of every device in the range - Stop at the first frame with nothing to send
+    for (uint8_t frameIndex = 0; frameIndex < MAX7219_MAX_DIGIT; frameIndex++) {
+        bool sending = false;
+        memset(buffer, 0, CHAIN_LENGTH(driver_context) * sizeof(max7219_command_t));
+        for (uint8_t chainIndex = firstChainIndex; chainIndex <= lastChainIndex; chainIndex++) {
+            uint8_t digitsMask = changed_digits_mask_private(changed_digits, firstIndex, chainIndex);
+            for (uint8_t rank = 0; rank < frameIndex; rank++) {
+                digitsMask &= digitsMask - 1;
+            }
+
+            if (digitsMask != 0) {
+                uint8_t digitIndex = __builtin_ctz(digitsMask);
+                uint8_t deviceIndex = CHAIN_LENGTH(driver_context) - 1 - chainIndex;
+                buffer[deviceIndex].address = MAX7219_DIGIT0_ADDRESS + digitIndex;
+                buffer[deviceIndex].data = changed_digits->digitCodes[chainIndex * MAX7219_MAX_DIGIT + digitIndex - firstIndex];
+                sending = true;
+            }
+        }
 
-    // Take exclusive access of the SPI bus
-    esp_err_t ret = ESP_OK;
-    ESP_GOTO_ON_ERROR(spi_device_acquire_bus(driver_context->spi_device_handle, portMAX_DELAY), cleanup, LedDriverMax7219LogTag, "Unable to acquire SPI bus");
+        if (!sending) {
+            break;
+        }
+        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context)), LedDriverMax7219LogTag, "Failed to send commands to chain");
+    }
 
-        ret = send_cb(driver_context, args);
+    return ESP_OK;
+}
 
-    // Release access to the SPI bus
-    spi_device_release_bus(driver_context->spi_device_handle);
+static esp_err_t send_chain_digit_set_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    chain_digit_set_t* digit_set = (chain_digit_set_t*)arg;
+    max7219_command_t* buffer = get_command_buffer_private(driver_context);
 
-cleanup:
-    // Release mutex
-    if (xSemaphoreGive(driver_context->mutex) != pdTRUE) {
-        ESP_LOGE(LedDriverMax7219LogTag, "Could not release mutex - Exiting without releasing mutex which may cause a deadlock later");
+    // 'pendingDigits[chainId - 1]' has bit (digit - 1) set for each digit to send - A chain frame carries one command per device
+    // so each frame sends the next pending digit of every device. The number of frames is the largest pending digit count of any device
+    bool pending = false;
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        pending |= digit_set->pendingDigits[chainIndex] != 0;
     }
 
-    return ret;
-}
+    // Nothing to send, for instance an unchanged frame - Do not send an all no-op transfer
+    while (pending) {
+        pending = false;
+        for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+            uint8_t deviceIndex = CHAIN_LENGTH(driver_context) - 1 - chainIndex;
+            uint8_t digitsMask = digit_set->pendingDigits[chainIndex];
+            if (digitsMask != 0) {
+                uint8_t digitIndex = __builtin_ctz(digitsMask);
+                buffer[deviceIndex].address = MAX7219_DIGIT0_ADDRESS + digitIndex;
+                buffer[deviceIndex].data = digit_set->digitCodes[chainIndex * MAX7219_MAX_DIGIT + digitIndex];
+                digitsMask &= digitsMask - 1;
+                digit_set->pendingDigits[chainIndex] = digitsMask;
+                pending |= digitsMask != 0;
+            } else {
+                buffer[deviceIndex].address = MAX7219_NOOP_ADDRESS;
+                buffer[deviceIndex].data = 0;
+            }
+        }
 
-static esp_err_t send_chain_one_command_callback(led_driver_max7219_context_t* driver_context, void* arg) {
-    chain_command_t* chain_command = (chain_command_t*)arg;
-    max7219_command_t* buffer = get_command_buffer_private(driver_context);
+        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context)), LedDriverMax7219LogTag, "Failed to send commands to chain");
+    }
+
+    return ESP_OK;
+}
+
+
+
+esp_err_t led_driver_max7219_enable_frame_buffers(led_driver_max7219_handle_t handle, uint8_t** backBuffer) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(backBuffer != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'backBuffer' must not be NULL");
+    ESP_RETURN_ON_FALSE(driver_context->frame_buffers == NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Frame buffers are already enabled");
+
+    // One allocation for the bookkeeping, four frames and one pending digits mask per device
+    const size_t frameSize = CHAIN_LENGTH(driver_context) * MAX7219_MAX_DIGIT;
+    max7219_frame_buffers_t* frame_buffers = heap_caps_calloc(1, sizeof(max7219_frame_buffers_t) + 4 * frameSize + CHAIN_LENGTH(driver_context), MALLOC_CAP_DEFAULT);
+    if (frame_buffers == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t* frames = (uint8_t*) (frame_buffers + 1);
+    portMUX_INITIALIZE(&frame_buffers->lock);
+    frame_buffers->back = frames;
+    frame_buffers->ready = frames + frameSize;
+    frame_buffers->spare = frames + 2 * frameSize;
+    frame_buffers->shown = frames + 3 * frameSize;
+    frame_buffers->pending_digits = frames + 4 * frameSize;
+
+    driver_context->frame_buffers = frame_buffers;
+    *backBuffer = frame_buffers->back;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_swap_buffers(led_driver_max7219_handle_t handle, uint8_t** backBuffer) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(backBuffer != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'backBuffer' must not be NULL");
+    max7219_frame_buffers_t* frame_buffers = driver_context->frame_buffers;
+    ESP_RETURN_ON_FALSE(frame_buffers != NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Frame buffers are not enabled");
+
+    // Publish the back buffer - The previous 'ready' frame, if never flushed, is dropped and becomes the new back buffer
+    portENTER_CRITICAL(&frame_buffers->lock);
+        uint8_t* published = frame_buffers->back;
+        frame_buffers->back = frame_buffers->ready;
+        frame_buffers->ready = published;
+        frame_buffers->frame_pending = true;
+    portEXIT_CRITICAL(&frame_buffers->lock);
+
+    // The flush path only ever reads frames so 'published' is stable - Start the next frame from the one just published
+    memcpy(frame_buffers->back, published, CHAIN_LENGTH(driver_context) * MAX7219_MAX_DIGIT);
+    *backBuffer = frame_buffers->back;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_flush(led_driver_max7219_handle_t handle) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(driver_context->frame_buffers != NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Frame buffers are not enabled");
+
+    return send_chain_with_callback_private(driver_context, MAX7219_LATENCY_API_FLUSH, send_chain_frame_callback, NULL);
+}
+
+static esp_err_t send_chain_frame_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    max7219_frame_buffers_t* frame_buffers = driver_context->frame_buffers;
+
+    // Take ownership of the last published frame, if any - Runs under the driver mutex so 'spare' and 'shown' are ours
+    portENTER_CRITICAL(&frame_buffers->lock);
+        bool framePending = frame_buffers->frame_pending;
+        if (framePending) {
+            uint8_t* frame = frame_buffers->ready;
+            frame_buffers->ready = frame_buffers->spare;
+            frame_buffers->spare = frame;
+            frame_buffers->frame_pending = false;
+        }
+    portEXIT_CRITICAL(&frame_buffers->lock);
+
+    if (!framePending) {
+        return ESP_OK;
+    }
+
+    // Only send digits which differ from what the chain displays, or all digits if digits were written outside of the frame buffers
+    const uint8_t* frame = frame_buffers->spare;
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        uint8_t digitsMask = 0;
+        for (uint8_t digitIndex = 0; digitIndex < MAX7219_MAX_DIGIT; digitIndex++) {
+            uint16_t index = chainIndex * MAX7219_MAX_DIGIT + digitIndex;
+            if (!frame_buffers->shown_valid || (frame[index] != frame_buffers->shown[index])) {
+                digitsMask |= 1 << digitIndex;
+            }
+        }
+        frame_buffers->pending_digits[chainIndex] = digitsMask;
+    }
+
+    // Until the frame is fully sent, the chain content is unknown
+    frame_buffers->shown_valid = false;
+    uint32_t foreignWrites = frame_buffers->foreign_writes;
+
+    chain_digit_set_t digit_set = { .digitCodes = frame, .pendingDigits = frame_buffers->pending_digits };
+    ESP_RETURN_ON_ERROR(send_chain_digit_set_callback(driver_context, &digit_set), LedDriverMax7219LogTag, "Failed to send frame");
+
+    // Digits may have been written between two transfers of this frame (e.g. urgent digits) - The chain then shows a mix
+    memcpy(frame_buffers->shown, frame, CHAIN_LENGTH(driver_context) * MAX7219_MAX_DIGIT);
+    frame_buffers->shown_valid = foreignWrites == frame_buffers->foreign_writes;
+    return ESP_OK;
+}
+
+
+
+esp_err_t led_driver_max7219_enable_priority_classes(led_driver_max7219_handle_t handle) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(driver_context->priority_classes == NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Priority classes are already enabled");
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+
+    // One allocation for the bookkeeping, the urgent and background mailboxes and the drain buffer
+    const size_t frameSize = CHAIN_LENGTH(driver_context) * MAX7219_MAX_DIGIT;
+    const size_t mailboxSize = frameSize + CHAIN_LENGTH(driver_context);
+    max7219_priority_classes_t* priority_classes = heap_caps_calloc(1, sizeof(max7219_priority_classes_t) + 3 * mailboxSize, MALLOC_CAP_DEFAULT);
+    if (priority_classes == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t* buffers = (uint8_t*) (priority_classes + 1);
+    portMUX_INITIALIZE(&priority_classes->urgent.lock);
+    priority_classes->urgent.codes = buffers;
+    priority_classes->urgent.pending_digits = buffers + frameSize;
+    portMUX_INITIALIZE(&priority_classes->background.lock);
+    priority_classes->background.codes = buffers + mailboxSize;
+    priority_classes->background.pending_digits = buffers + mailboxSize + frameSize;
+    priority_classes->drain_codes = buffers + 2 * mailboxSize;
+    priority_classes->drain_digits = buffers + 2 * mailboxSize + frameSize;
+    portMUX_INITIALIZE(&priority_classes->stats_lock);
+
+    driver_context->priority_classes = priority_classes;
+    return ESP_OK;
+#endif
+}
+
+esp_err_t led_driver_max7219_set_digit_with_priority(led_driver_max7219_handle_t handle, uint8_t chainId, uint8_t digit, uint8_t digitCode, max7219_priority_t priority) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_ERROR(check_max_chain_id_private(driver_context, chainId), LedDriverMax7219LogTag, "Invalid chain ID");
+    ESP_RETURN_ON_ERROR(check_max_digit_private(driver_context, digit), LedDriverMax7219LogTag, "Invalid digit");
+    max7219_priority_classes_t* priority_classes = driver_context->priority_classes;
+    ESP_RETURN_ON_FALSE(priority_classes != NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Priority classes are not enabled");
+
+    switch (priority) {
+        case MAX7219_PRIORITY_URGENT:
+            stage_digit_private(&priority_classes->urgent, chainId, digit, digitCode);
+            return try_drain_pending_private(driver_context);
+
+        case MAX7219_PRIORITY_NORMAL: {
+            int64_t startUs = esp_timer_get_time();
+            esp_err_t err = DRIVER_API(driver_context, set_digits)(driver_context, chainId, digit, &digitCode, 1);
+            if (err == ESP_OK) {
+                record_latency_private(driver_context, MAX7219_PRIORITY_NORMAL, esp_timer_get_time() - startUs);
+            }
+            return err;
+        }
+
+        case MAX7219_PRIORITY_BACKGROUND:
+            stage_digit_private(&priority_classes->background, chainId, digit, digitCode);
+            return try_drain_pending_private(driver_context);
+
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+}
+
+esp_err_t led_driver_max7219_get_priority_latency(led_driver_max7219_handle_t handle, max7219_priority_latency_t* latency, bool reset) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(latency != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'latency' must not be NULL");
+    max7219_priority_classes_t* priority_classes = driver_context->priority_classes;
+    ESP_RETURN_ON_FALSE(priority_classes != NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Priority classes are not enabled");
+
+    portENTER_CRITICAL(&priority_classes->stats_lock);
+        *latency = priority_classes->stats;
+        if (reset) {
+            memset(&priority_classes->stats, 0, sizeof(priority_classes->stats));
+        }
+    portEXIT_CRITICAL(&priority_classes->stats_lock);
+
+    return ESP_OK;
+}
+
+static void stage_digit_private(max7219_digit_mailbox_t* mailbox, uint8_t chainId, uint8_t digit, uint8_t digitCode) {
+    int64_t nowUs = esp_timer_get_time();
+    portENTER_CRITICAL(&mailbox->lock);
+        mailbox->codes[MAX7219_FRAME_INDEX(chainId, digit)] = digitCode;
+        mailbox->pending_digits[chainId - 1] |= 1 << (digit - 1);
+        if (!mailbox->pending) {
+            mailbox->oldest_us = nowUs;
+            mailbox->pending = true;
+        }
+    portEXIT_CRITICAL(&mailbox->lock);
+}
+
+static bool take_mailbox_private(led_driver_max7219_context_t* driver_context, max7219_digit_mailbox_t* mailbox, uint8_t* drainCodes, uint8_t* drainDigits, int64_t* oldestUs) {
+    // Move staged digits to the drain buffers so producers can stage new digits while we send - Must be called with the driver mutex held
+    bool pending = false;
+    portENTER_CRITICAL(&mailbox->lock);
+        if (mailbox->pending) {
+            for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+                uint8_t digitsMask = mailbox->pending_digits[chainIndex];
+                drainDigits[chainIndex] = digitsMask;
+                if (digitsMask != 0) {
+                    memcpy(&drainCodes[chainIndex * MAX7219_MAX_DIGIT], &mailbox->codes[chainIndex * MAX7219_MAX_DIGIT], MAX7219_MAX_DIGIT);
+                    mailbox->pending_digits[chainIndex] = 0;
+                }
+            }
+            *oldestUs = mailbox->oldest_us;
+            mailbox->pending = false;
+            pending = true;
+        }
+    portEXIT_CRITICAL(&mailbox->lock);
+
+    return pending;
+}
+
+static esp_err_t drain_mailbox_private(led_driver_max7219_context_t* driver_context, max7219_digit_mailbox_t* mailbox, max7219_priority_t priority) {
+    max7219_priority_classes_t* priority_classes = driver_context->priority_classes;
+
+    int64_t oldestUs = 0;
+    if (!take_mailbox_private(driver_context, mailbox, priority_classes->drain_codes, priority_classes->drain_digits, &oldestUs)) {
+        return ESP_OK;
+    }
+
+    invalidate_shown_frame_private(driver_context);
+    chain_digit_set_t digit_set = { .digitCodes = priority_classes->drain_codes, .pendingDigits = priority_classes->drain_digits };
+    esp_err_t err = send_chain_digit_set_callback(driver_context, &digit_set);
+    if (err == ESP_OK) {
+        record_latency_private(driver_context, priority, esp_timer_get_time() - oldestUs);
+    }
+    return err;
+}
+
+static esp_err_t drain_pending_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called with the driver mutex and the SPI bus held - Drains urgent digits first, then background digits
+    max7219_priority_classes_t* priority_classes = driver_context->priority_classes;
+    if ((priority_classes == NULL) || priority_classes->draining) {
+        return ESP_OK;
+    }
+
+    priority_classes->draining = true;
+    esp_err_t err = drain_mailbox_private(driver_context, &priority_classes->urgent, MAX7219_PRIORITY_URGENT);
+    if (err == ESP_OK) {
+        err = drain_mailbox_private(driver_context, &priority_classes->background, MAX7219_PRIORITY_BACKGROUND);
+    }
+    priority_classes->draining = false;
+
+    return err;
+}
+
+static esp_err_t try_drain_pending_private(led_driver_max7219_context_t* driver_context) {
+    // Drain staged digits if the driver is idle - Otherwise the task owning the driver mutex drains them before it releases the mutex
+    // and checks again after releasing it so digits staged while it was giving the mutex are not left behind
+    max7219_priority_classes_t* priority_classes = driver_context->priority_classes;
+    esp_err_t err = ESP_OK;
+    while ((priority_classes != NULL) && (priority_classes->urgent.pending || priority_classes->background.pending)) {
+        if (take_driver_mutex_private(driver_context, 0) != pdTRUE) {
+            break;
+        }
+
+        err = acquire_bus_private(driver_context);
+        if (err == ESP_OK) {
+            err = finish_operation_private(driver_context);
+            release_bus_private(driver_context);
+        }
+
+        if (give_driver_mutex_private(driver_context) != pdTRUE) {
+            ESP_LOGE(LedDriverMax7219LogTag, "Could not release mutex - Exiting without releasing mutex which may cause a deadlock later");
+        }
+
+        if (err != ESP_OK) {
+            break;
+        }
+    }
+
+    return err;
+}
+
+static esp_err_t finish_operation_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called with the driver mutex and the SPI bus held, at the end of every operation
+    esp_err_t err = drain_pending_private(driver_context);
+    esp_err_t powerErr = apply_power_policy_private(driver_context);
+    return err == ESP_OK ? powerErr : err;
+}
+
+static void record_latency_private(led_driver_max7219_context_t* driver_context, max7219_priority_t priority, int64_t latencyUs) {
+    max7219_priority_classes_t* priority_classes = driver_context->priority_classes;
+    if (priority_classes != NULL) {
+        uint32_t latency = latencyUs > UINT32_MAX ? UINT32_MAX : (uint32_t) latencyUs;
+        portENTER_CRITICAL(&priority_classes->stats_lock);
+            if (latency > priority_classes->stats.worst_us[priority]) {
+                priority_classes->stats.worst_us[priority] = latency;
+            }
+            priority_classes->stats.count[priority]++;
+        portEXIT_CRITICAL(&priority_classes->stats_lock);
+    }
+}
+
+
+
+static bool enter_timer_callback_private(led_driver_max7219_context_t* driver_context) {
+    // Timer callbacks run on the esp_timer task, one at a time - A callback only touches the driver between enter and exit
+    portENTER_CRITICAL(&TimerCallbacksLock);
+        bool entered = !driver_context->closing;
+        driver_context->in_timer_callback = entered;
+    portEXIT_CRITICAL(&TimerCallbacksLock);
+    return entered;
+}
+
+static void exit_timer_callback_private(led_driver_max7219_context_t* driver_context) {
+    portENTER_CRITICAL(&TimerCallbacksLock);
+        driver_context->in_timer_callback = false;
+    portEXIT_CRITICAL(&TimerCallbacksLock);
+}
+
+static void close_timer_callbacks_private(led_driver_max7219_context_t* driver_context) {
+    // Callbacks never wait for the driver mutex so the one in flight, if any, completes once the SPI bus is available
+    bool inCallback = true;
+    portENTER_CRITICAL(&TimerCallbacksLock);
+        driver_context->closing = true;
+    portEXIT_CRITICAL(&TimerCallbacksLock);
+
+    while (inCallback) {
+        portENTER_CRITICAL(&TimerCallbacksLock);
+            inCallback = driver_context->in_timer_callback;
+        portEXIT_CRITICAL(&TimerCallbacksLock);
+        if (inCallback) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+static void delete_timers_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called with the driver mutex held, after close_timer_callbacks_private()
+    max7219_power_manager_t* power_manager = driver_context->power_manager;
+    if ((power_manager != NULL) && (power_manager->idle_timer != NULL)) {
+        esp_timer_stop(power_manager->idle_timer);
+        esp_timer_delete(power_manager->idle_timer);
+        power_manager->idle_timer = NULL;
+    }
+
+    max7219_write_combiner_t* write_combiner = driver_context->write_combiner;
+    if ((write_combiner != NULL) && (write_combiner->window_timer != NULL)) {
+        esp_timer_stop(write_combiner->window_timer);
+        esp_timer_delete(write_combiner->window_timer);
+        write_combiner->window_timer = NULL;
+    }
+}
+
+static bool is_mailbox_pending_private(max7219_digit_mailbox_t* mailbox) {
+    portENTER_CRITICAL(&mailbox->lock);
+        bool pending = mailbox->pending;
+    portEXIT_CRITICAL(&mailbox->lock);
+    return pending;
+}
+
+
+
+esp_err_t led_driver_max7219_set_write_combining_window(led_driver_max7219_handle_t handle, uint32_t windowMs) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(windowMs <= UINT32_MAX / 1000, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "windowMs is out of range");
+
+    // Disabling write combining sends staged digits right away - The combiner is kept until the driver is freed so concurrent setters never see it go away
+    max7219_write_combiner_t* write_combiner = driver_context->write_combiner;
+    if (windowMs == 0) {
+        if (write_combiner == NULL) {
+            return ESP_OK;
+        }
+        write_combiner->window_us = 0;
+        esp_timer_stop(write_combiner->window_timer);
+        return send_chain_with_callback_private(driver_context, MAX7219_LATENCY_API_SET_DIGITS, send_chain_combined_digits_callback, NULL);
+    }
+
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+
+    if (write_combiner == NULL) {
+        // One allocation for the bookkeeping, the mailbox and the drain buffers
+        const size_t frameSize = CHAIN_LENGTH(driver_context) * MAX7219_MAX_DIGIT;
+        const size_t mailboxSize = frameSize + CHAIN_LENGTH(driver_context);
+        write_combiner = heap_caps_calloc(1, sizeof(max7219_write_combiner_t) + 2 * mailboxSize, MALLOC_CAP_DEFAULT);
+        if (write_combiner == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        uint8_t* buffers = (uint8_t*) (write_combiner + 1);
+        portMUX_INITIALIZE(&write_combiner->mailbox.lock);
+        write_combiner->mailbox.codes = buffers;
+        write_combiner->mailbox.pending_digits = buffers + frameSize;
+        write_combiner->drain_codes = buffers + mailboxSize;
+        write_combiner->drain_digits = buffers + mailboxSize + frameSize;
+
+        esp_timer_create_args_t timerArgs = {
+            .callback = write_combining_timer_callback,
+            .arg = driver_context,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "max7219_combine",
+            .skip_unhandled_events = true
+        };
+        esp_err_t err = esp_timer_create(&timerArgs, &write_combiner->window_timer);
+        if (err != ESP_OK) {
+            heap_caps_free(write_combiner);
+            return err;
+        }
+
+        ESP_RETURN_ON_FALSE(take_driver_mutex_private(driver_context, portMAX_DELAY) == pdTRUE, ESP_ERR_TIMEOUT, LedDriverMax7219LogTag, "Could not acquire mutex");
+            driver_context->write_combiner = write_combiner;
+        give_driver_mutex_private(driver_context);
+    }
+
+    write_combiner->window_us = windowMs * 1000;
+    return ESP_OK;
+#endif
+}
+
+static esp_err_t combine_digits_private(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, const uint8_t digitCodes[], uint16_t digitCodesCount) {
+    max7219_write_combiner_t* write_combiner = driver_context->write_combiner;
+    max7219_digit_mailbox_t* mailbox = &write_combiner->mailbox;
+
+    // Latest value wins - The first staged digit opens the window. A coalesced update the timer failed to send is reported here
+    int64_t nowUs = esp_timer_get_time();
+    bool opened = false;
+    portENTER_CRITICAL(&mailbox->lock);
+        esp_err_t windowErr = write_combiner->error;
+        write_combiner->error = ESP_OK;
+        if (startChainId == 0) {
+            // One digit code for all digits of all devices
+            memset(mailbox->codes, digitCodes[0], CHAIN_LENGTH(driver_context) * MAX7219_MAX_DIGIT);
+            memset(mailbox->pending_digits, 0xFF, CHAIN_LENGTH(driver_context));
+        } else {
+            uint16_t frameIndex = MAX7219_FRAME_INDEX(startChainId, startDigitId);
+            for (uint16_t codeIndex = 0; codeIndex < digitCodesCount; codeIndex++, frameIndex++) {
+                mailbox->codes[frameIndex] = digitCodes[codeIndex];
+                mailbox->pending_digits[frameIndex / MAX7219_MAX_DIGIT] |= 1 << (frameIndex % MAX7219_MAX_DIGIT);
+            }
+        }
+        if (!mailbox->pending) {
+            mailbox->oldest_us = nowUs;
+            mailbox->pending = true;
+            opened = true;
+        }
+    portEXIT_CRITICAL(&mailbox->lock);
+
+    if (!opened) {
+        return windowErr;
+    }
+
+    // The timer may still be armed if an operation sent the staged digits before the previous window closed - That window then closes early
+    esp_err_t err = esp_timer_start_once(write_combiner->window_timer, write_combiner->window_us);
+    err = err == ESP_ERR_INVALID_STATE ? ESP_OK : err;
+    return windowErr != ESP_OK ? windowErr : err;
+}
+
+static esp_err_t drain_write_combiner_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called with the driver mutex and the SPI bus held
+    max7219_write_combiner_t* write_combiner = driver_context->write_combiner;
+    int64_t oldestUs = 0;
+    if ((write_combiner == NULL) || !take_mailbox_private(driver_context, &write_combiner->mailbox, write_combiner->drain_codes, write_combiner->drain_digits, &oldestUs)) {
+        return ESP_OK;
+    }
+
+    invalidate_shown_frame_private(driver_context);
+    chain_digit_set_t digit_set = { .digitCodes = write_combiner->drain_codes, .pendingDigits = write_combiner->drain_digits };
+    return send_chain_digit_set_callback(driver_context, &digit_set);
+}
+
+static esp_err_t send_chain_combined_digits_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    // Every operation sends staged digits before invoking its callback - Nothing is left to do, the operation itself sends the coalesced update
+    return ESP_OK;
+}
+
+static void write_combining_timer_callback(void* arg) {
+    led_driver_max7219_context_t* driver_context = (led_driver_max7219_context_t*) arg;
+    if (!enter_timer_callback_private(driver_context)) {
+        return;
+    }
+
+    // The window closed - Send the coalesced update unless another operation already did
+    // NOTE: The esp_timer task is shared - When the driver is busy, try again once another window elapsed instead of waiting
+    max7219_write_combiner_t* write_combiner = driver_context->write_combiner;
+    if (is_mailbox_pending_private(&write_combiner->mailbox)) {
+        esp_err_t err = send_chain_with_timeout_private(driver_context, MAX7219_LATENCY_API_SET_DIGITS, 0, send_chain_combined_digits_callback, NULL);
+        uint32_t windowUs = write_combiner->window_us;
+        if ((err == ESP_ERR_TIMEOUT) && (windowUs > 0)) {
+            esp_timer_start_once(write_combiner->window_timer, windowUs);
+        } else if ((err != ESP_OK) && (err != ESP_ERR_TIMEOUT)) {
+            portENTER_CRITICAL(&write_combiner->mailbox.lock);
+                write_combiner->error = err;
+            portEXIT_CRITICAL(&write_combiner->mailbox.lock);
+        }
+    }
+
+    exit_timer_callback_private(driver_context);
+}
+
+
+
+esp_err_t led_driver_max7219_set_power_policy(led_driver_max7219_handle_t handle, const max7219_power_policy_t* policy) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+
+    // Disabling the policy wakes up devices it shut down
+    if ((policy == NULL) || (!policy->shutdown_blank_devices && (policy->idle_timeout_ms == 0))) {
+        if (driver_context->power_manager == NULL) {
+            return ESP_OK;
+        }
+        return send_chain_with_callback_private(driver_context, MAX7219_LATENCY_API_SET_MODE, send_chain_power_policy_off_callback, NULL);
+    }
+
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    ESP_RETURN_ON_FALSE(policy->idle_timeout_ms == 0, ESP_ERR_NOT_SUPPORTED, LedDriverMax7219LogTag, "'idle_timeout_ms' is not supported with CONFIG_MAX_7219_7221_SINGLE_OWNER");
+#endif
+
+    // The manager is allocated under the driver mutex so concurrent callers share one manager and one idle timer
+    ESP_RETURN_ON_FALSE(take_driver_mutex_private(driver_context, portMAX_DELAY) == pdTRUE, ESP_ERR_TIMEOUT, LedDriverMax7219LogTag, "Could not acquire mutex");
+    esp_err_t err = ESP_OK;
+    if (driver_context->power_manager == NULL) {
+        err = create_power_manager_private(driver_context);
+    }
+    if (err == ESP_OK) {
+        driver_context->power_manager->policy = *policy;
+    }
+    give_driver_mutex_private(driver_context);
+
+    return err;
+}
+
+static esp_err_t create_power_manager_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called with the driver mutex held - One allocation for the bookkeeping, the register mirror, known registers and auto shutdown flags
+    const size_t registersSize = CHAIN_LENGTH(driver_context) * 16;
+    max7219_power_manager_t* power_manager = heap_caps_calloc(1, sizeof(max7219_power_manager_t) + registersSize + CHAIN_LENGTH(driver_context) * (sizeof(uint16_t) + sizeof(uint8_t)), MALLOC_CAP_DEFAULT);
+    if (power_manager == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t* buffers = (uint8_t*) (power_manager + 1);
+    power_manager->known_registers = (uint16_t*) buffers;
+    power_manager->registers = buffers + CHAIN_LENGTH(driver_context) * sizeof(uint16_t);
+    power_manager->auto_shutdown = power_manager->registers + registersSize;
+
+    // Modes sent before the policy was set, including the initial state, were not mirrored - Devices start managed, as if in normal mode,
+    // until the application sets their mode. Digits stay unknown, and considered lit, until they are written
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        power_manager->registers[chainIndex * 16 + MAX7219_SHUTDOWN_ADDRESS] = 1;
+        power_manager->known_registers[chainIndex] = 1 << MAX7219_SHUTDOWN_ADDRESS;
+    }
+
+    esp_timer_create_args_t timerArgs = {
+        .callback = idle_timer_callback,
+        .arg = driver_context,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "max7219_idle",
+        .skip_unhandled_events = true
+    };
+    esp_err_t err = esp_timer_create(&timerArgs, &power_manager->idle_timer);
+    if (err != ESP_OK) {
+        heap_caps_free(power_manager);
+        return err;
+    }
+
+    // The register mirror is kept when the policy changes so we do not forget what the chain displays
+    driver_context->power_manager = power_manager;
+    return ESP_OK;
+}
+
+static void free_power_manager_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called with the driver mutex held - The idle timer callback finds no power manager once it gets the driver
+    max7219_power_manager_t* power_manager = driver_context->power_manager;
+    if (power_manager != NULL) {
+        if (power_manager->idle_timer != NULL) {
+            esp_timer_stop(power_manager->idle_timer);
+            esp_timer_delete(power_manager->idle_timer);
+        }
+        driver_context->power_manager = NULL;
+        heap_caps_free(power_manager);
+    }
+}
+
+static esp_err_t send_chain_power_policy_off_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    // Wake up devices the policy shut down, then forget the policy so the end of this operation does not apply it again
+    max7219_power_manager_t* power_manager = driver_context->power_manager;
+    if (power_manager == NULL) {
+        return ESP_OK;
+    }
+
+    bool shutdown[CHAIN_LENGTH(driver_context)];
+    bool changes = false;
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        shutdown[chainIndex] = false;
+        changes |= power_manager->auto_shutdown[chainIndex];
+    }
+
+    esp_err_t err = changes ? send_shutdown_changes_private(driver_context, shutdown) : ESP_OK;
+    free_power_manager_private(driver_context);
+    return err;
+}
+
+static void mirror_commands_private(led_driver_max7219_context_t* driver_context, const max7219_command_t* const data) {
+    max7219_power_manager_t* power_manager = driver_context->power_manager;
+    for (uint8_t deviceIndex = 0; deviceIndex < CHAIN_LENGTH(driver_context); deviceIndex++) {
+        uint8_t address = data[deviceIndex].address & 0x0F;
+        if (address != MAX7219_NOOP_ADDRESS) {
+            uint8_t chainIndex = CHAIN_LENGTH(driver_context) - 1 - deviceIndex;
+            power_manager->registers[chainIndex * 16 + address] = data[deviceIndex].data;
+            power_manager->known_registers[chainIndex] |= 1 << address;
+
+            // A mode set by the application overrides whatever the policy did
+            if ((address == MAX7219_SHUTDOWN_ADDRESS) && !power_manager->sending) {
+                power_manager->auto_shutdown[chainIndex] = false;
+            }
+        }
+    }
+}
+
+static bool is_device_managed_private(const max7219_power_manager_t* power_manager, uint8_t chainIndex) {
+    // Only devices the application put in normal mode, and not in test mode, are managed - Devices shut down by the policy are still in normal mode in the mirror
+    const uint8_t* registers = &power_manager->registers[chainIndex * 16];
+    return (registers[MAX7219_SHUTDOWN_ADDRESS] & 0x01) && !(registers[MAX7219_TEST_ADDRESS] & 0x01);
+}
+
+static bool is_device_blank_private(const max7219_power_manager_t* power_manager, uint8_t chainIndex) {
+    // Digits never written are unknown and considered lit
+    const uint16_t digitsMask = 0x01FE;
+    if ((power_manager->known_registers[chainIndex] & digitsMask) != digitsMask) {
+        return false;
+    }
+
+    const uint8_t* registers = &power_manager->registers[chainIndex * 16];
+    uint8_t decodeMode = (power_manager->known_registers[chainIndex] & (1 << MAX7219_DECODE_MODE_ADDRESS)) ? registers[MAX7219_DECODE_MODE_ADDRESS] : MAX7219_CODE_B_DECODE_NONE;
+    for (uint8_t digitIndex = 0; digitIndex < MAX7219_MAX_DIGIT; digitIndex++) {
+        uint8_t digitCode = registers[MAX7219_DIGIT0_ADDRESS + digitIndex];
+        // Code B ignores bits 4 to 6 and blanks on 0x0F, no decode blanks when no segment is on
+        bool blank = decodeMode & (1 << digitIndex) ? (digitCode & 0x8F) == MAX7219_CODE_B_BLANK : digitCode == MAX7219_DIRECT_ADDRESSING_BLANK;
+        if (!blank) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static esp_err_t apply_power_policy_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called with the driver mutex and the SPI bus held, at the end of every operation - The policy stops once the driver is being freed
+    max7219_power_manager_t* power_manager = driver_context->power_manager;
+    if ((power_manager == NULL) || power_manager->sending || driver_context->closing) {
+        return ESP_OK;
+    }
+
+    // 'shutdown[chainIndex]' is the wanted state of managed devices - Any operation ends an idle shutdown but blank devices stay in shutdown
+    bool shutdown[CHAIN_LENGTH(driver_context)];
+    bool changes = false;
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        shutdown[chainIndex] = power_manager->policy.shutdown_blank_devices && is_device_blank_private(power_manager, chainIndex);
+        changes |= is_device_managed_private(power_manager, chainIndex) && (shutdown[chainIndex] != power_manager->auto_shutdown[chainIndex]);
+    }
+    power_manager->idle_shutdown = false;
+
+    esp_err_t err = changes ? send_shutdown_changes_private(driver_context, shutdown) : ESP_OK;
+
+    // Restart the idle countdown
+    if (power_manager->policy.idle_timeout_ms > 0) {
+        esp_timer_stop(power_manager->idle_timer);
+        esp_timer_start_once(power_manager->idle_timer, (uint64_t) power_manager->policy.idle_timeout_ms * 1000);
+    }
+
+    return err;
+}
+
+static esp_err_t send_shutdown_changes_private(led_driver_max7219_context_t* driver_context, const bool shutdown[]) {
+    // One chain transfer carries the shutdown register of every device whose state changes - Other devices receive a no-op
+    max7219_power_manager_t* power_manager = driver_context->power_manager;
+    max7219_command_t* buffer = get_command_buffer_private(driver_context);
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        uint8_t deviceIndex = CHAIN_LENGTH(driver_context) - 1 - chainIndex;
+        if (is_device_managed_private(power_manager, chainIndex) && (shutdown[chainIndex] != power_manager->auto_shutdown[chainIndex])) {
+            buffer[deviceIndex].address = MAX7219_SHUTDOWN_ADDRESS;
+            buffer[deviceIndex].data = shutdown[chainIndex] ? 0 : 1;
+            power_manager->auto_shutdown[chainIndex] = shutdown[chainIndex];
+        } else {
+            buffer[deviceIndex].address = MAX7219_NOOP_ADDRESS;
+            buffer[deviceIndex].data = 0;
+        }
+    }
+
+    // The mirror records the shutdown register as written by the policy - A device in 'auto_shutdown' is still in normal mode for the application
+    power_manager->sending = true;
+    esp_err_t err = spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context));
+    power_manager->sending = false;
+    for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+        if (power_manager->auto_shutdown[chainIndex]) {
+            power_manager->registers[chainIndex * 16 + MAX7219_SHUTDOWN_ADDRESS] = 1;
+        }
+    }
+
+    return err;
+}
+
+static void idle_timer_callback(void* arg) {
+    led_driver_max7219_context_t* driver_context = (led_driver_max7219_context_t*) arg;
+    if (!enter_timer_callback_private(driver_context)) {
+        return;
+    }
+
+    // If the driver is busy, the operation in progress restarts the idle countdown
+    if (take_driver_mutex_private(driver_context, 0) != pdTRUE) {
+        exit_timer_callback_private(driver_context);
+        return;
+    }
+
+    max7219_power_manager_t* power_manager = driver_context->power_manager;
+    if ((power_manager != NULL) && !power_manager->idle_shutdown && (acquire_bus_private(driver_context) == ESP_OK)) {
+        // Shut down every device in normal mode - The next operation wakes them up
+        bool shutdown[CHAIN_LENGTH(driver_context)];
+        for (uint8_t chainIndex = 0; chainIndex < CHAIN_LENGTH(driver_context); chainIndex++) {
+            shutdown[chainIndex] = true;
+        }
+
+        esp_err_t err = send_shutdown_changes_private(driver_context, shutdown);
+        if (err != ESP_OK) {
+            ESP_LOGW(LedDriverMax7219LogTag, "Failed to shut down idle chain (%d)", err);
+        }
+        power_manager->idle_shutdown = true;
+
+        release_bus_private(driver_context);
+    }
+
+    give_driver_mutex_private(driver_context);
+    exit_timer_callback_private(driver_context);
+}
+
+
+
+esp_err_t led_driver_max7219_enable_latency_tracing(led_driver_max7219_handle_t handle) {
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+
+    if (driver_context->latency_tracer != NULL) {
+        return ESP_OK;
+    }
+
+    max7219_latency_tracer_t* latency_tracer = heap_caps_calloc(1, sizeof(max7219_latency_tracer_t), MALLOC_CAP_DEFAULT);
+    if (latency_tracer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    portMUX_INITIALIZE(&latency_tracer->lock);
+
+    // Publish under the driver mutex so an operation in progress does not see the tracer half way through
+    ESP_RETURN_ON_FALSE(take_driver_mutex_private(driver_context, portMAX_DELAY) == pdTRUE, ESP_ERR_TIMEOUT, LedDriverMax7219LogTag, "Could not acquire mutex");
+        driver_context->latency_tracer = latency_tracer;
+    give_driver_mutex_private(driver_context);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t led_driver_max7219_get_latency_trace(led_driver_max7219_handle_t handle, max7219_latency_trace_t* trace, bool reset) {
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(trace != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'trace' must not be NULL");
+
+    max7219_latency_tracer_t* latency_tracer = driver_context->latency_tracer;
+    ESP_RETURN_ON_FALSE(latency_tracer != NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Latency tracing is not enabled");
+
+    portENTER_CRITICAL(&latency_tracer->lock);
+        *trace = latency_tracer->trace;
+        if (reset) {
+            memset(&latency_tracer->trace, 0, sizeof(max7219_latency_trace_t));
+        }
+    portEXIT_CRITICAL(&latency_tracer->lock);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+static void add_latency_sample_private(max7219_latency_histogram_t* histogram, int64_t latencyUs) {
+    // Bucket 'n' holds latencies in [2^(n-1), 2^n) - The last bucket holds everything longer
+    uint32_t latency = latencyUs < 0 ? 0 : (latencyUs > UINT32_MAX ? UINT32_MAX : (uint32_t) latencyUs);
+    uint8_t bucket = latency == 0 ? 0 : 32 - __builtin_clz(latency);
+    histogram->buckets[bucket < MAX7219_LATENCY_BUCKET_COUNT ? bucket : MAX7219_LATENCY_BUCKET_COUNT - 1]++;
+    histogram->count++;
+    if (latency > histogram->max_us) {
+        histogram->max_us = latency;
+    }
+}
+#endif
+
+static inline void begin_operation_latency_private(led_driver_max7219_context_t* driver_context) {
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    // Must be called with the driver mutex held
+    if (driver_context->latency_tracer != NULL) {
+        driver_context->latency_tracer->transmit_us = 0;
+    }
+#endif
+}
+
+static inline void record_transmit_latency_private(led_driver_max7219_context_t* driver_context, int64_t transmitUs) {
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    // Must be called with the driver mutex held
+    if (driver_context->latency_tracer != NULL) {
+        driver_context->latency_tracer->transmit_us += transmitUs;
+    }
+#endif
+}
+
+static inline void record_operation_latency_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, int64_t startUs, int64_t mutexUs, int64_t busUs, int64_t sentUs) {
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    // Must be called with the driver mutex held - Encoding is whatever time was not spent transmitting once the bus was ours
+    max7219_latency_tracer_t* latency_tracer = driver_context->latency_tracer;
+    if ((latency_tracer != NULL) && (api != LATENCY_API_UNTRACED)) {
+        max7219_latency_histogram_t* histograms = latency_tracer->trace.histograms[api];
+        portENTER_CRITICAL(&latency_tracer->lock);
+            add_latency_sample_private(&histograms[MAX7219_LATENCY_STAGE_MUTEX_WAIT], mutexUs - startUs);
+            add_latency_sample_private(&histograms[MAX7219_LATENCY_STAGE_BUS_ACQUIRE], busUs - mutexUs);
+            add_latency_sample_private(&histograms[MAX7219_LATENCY_STAGE_ENCODE], sentUs - busUs - latency_tracer->transmit_us);
+            add_latency_sample_private(&histograms[MAX7219_LATENCY_STAGE_TRANSMIT], latency_tracer->transmit_us);
+            add_latency_sample_private(&histograms[MAX7219_LATENCY_STAGE_TOTAL], sentUs - startUs);
+        portEXIT_CRITICAL(&latency_tracer->lock);
+    }
+#endif
+}
+
+
+
+esp_err_t led_driver_max7219_enable_capture(led_driver_max7219_handle_t handle, uint16_t recordCount) {
+#if CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(recordCount > 0, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'recordCount' must be > 0");
+    ESP_RETURN_ON_FALSE(driver_context->capture_ring == NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Capture is already enabled");
+
+    const uint16_t recordSize = sizeof(max7219_capture_record_t) + CHAIN_LENGTH(driver_context) * sizeof(max7219_command_t);
+    max7219_capture_ring_t* capture_ring = heap_caps_calloc(1, sizeof(max7219_capture_ring_t) + (size_t) recordCount * recordSize, MALLOC_CAP_DEFAULT);
+    if (capture_ring == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    portMUX_INITIALIZE(&capture_ring->lock);
+    capture_ring->record_size = recordSize;
+    capture_ring->capacity = recordCount;
+
+    int clockSpeedKhz = 0;
+    if (spi_device_get_actual_freq(driver_context->spi_device_handle, &clockSpeedKhz) == ESP_OK) {
+        capture_ring->clock_speed_hz = (uint32_t) clockSpeedKhz * 1000;
+    }
+
+    // Publish under the driver mutex so a transfer in progress does not see the ring half way through
+    ESP_RETURN_ON_FALSE(take_driver_mutex_private(driver_context, portMAX_DELAY) == pdTRUE, ESP_ERR_TIMEOUT, LedDriverMax7219LogTag, "Could not acquire mutex");
+        driver_context->capture_ring = capture_ring;
+    give_driver_mutex_private(driver_context);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t led_driver_max7219_read_capture(led_driver_max7219_handle_t handle, uint8_t* buffer, size_t bufferSize, size_t* length) {
+#if CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE((buffer != NULL) && (length != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'buffer' and 'length' must not be NULL");
+
+    max7219_capture_ring_t* capture_ring = driver_context->capture_ring;
+    ESP_RETURN_ON_FALSE(capture_ring != NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219LogTag, "Capture is not enabled");
+    ESP_RETURN_ON_FALSE(bufferSize >= sizeof(max7219_capture_header_t) + capture_ring->record_size, ESP_ERR_INVALID_SIZE, LedDriverMax7219LogTag, "'buffer' must hold at least one record");
+
+    // Move records one at a time so transfers are not held up for long - Records read are removed from the ring
+    const uint16_t maxRecords = (bufferSize - sizeof(max7219_capture_header_t)) / capture_ring->record_size;
+    uint8_t* record = buffer + sizeof(max7219_capture_header_t);
+    max7219_capture_header_t header = {
+        .magic = MAX7219_CAPTURE_MAGIC,
+        .version = MAX7219_CAPTURE_VERSION,
+        .chain_length = CHAIN_LENGTH(driver_context),
+        .record_count = 0,
+        .clock_speed_hz = capture_ring->clock_speed_hz
+    };
+    while (header.record_count < maxRecords) {
+        bool copied = false;
+        portENTER_CRITICAL(&capture_ring->lock);
+            if (header.record_count == 0) {
+                header.dropped_records = capture_ring->dropped;
+                capture_ring->dropped = 0;
+            }
+            if (capture_ring->count > 0) {
+                memcpy(record, &capture_ring->records[capture_ring->head * capture_ring->record_size], capture_ring->record_size);
+                capture_ring->head = (capture_ring->head + 1) % capture_ring->capacity;
+                capture_ring->count--;
+                copied = true;
+            }
+        portEXIT_CRITICAL(&capture_ring->lock);
+
+        if (!copied) {
+            break;
+        }
+        record += capture_ring->record_size;
+        header.record_count++;
+    }
+
+    memcpy(buffer, &header, sizeof(max7219_capture_header_t));
+    *length = record - buffer;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static inline void capture_transfer_private(led_driver_max7219_context_t* driver_context, int64_t startUs, int64_t endUs, const void* data, uint16_t lengthInBytes) {
+#if CONFIG_MAX_7219_7221_ENABLE_CAPTURE
+    // Must be called with the driver mutex held - Overwrites the oldest record when the ring is full
+    max7219_capture_ring_t* capture_ring = driver_context->capture_ring;
+    if (capture_ring != NULL) {
+        int64_t durationUs = endUs - startUs;
+        max7219_capture_record_t recordHeader = {
+            .timestamp_us = (uint32_t) startUs,
+            .duration_us = durationUs > UINT16_MAX ? UINT16_MAX : (uint16_t) durationUs
+        };
+
+        portENTER_CRITICAL(&capture_ring->lock);
+            uint16_t slot = (capture_ring->head + capture_ring->count) % capture_ring->capacity;
+            if (capture_ring->count == capture_ring->capacity) {
+                capture_ring->head = (capture_ring->head + 1) % capture_ring->capacity;
+                capture_ring->dropped++;
+            } else {
+                capture_ring->count++;
+            }
+            uint8_t* record = &capture_ring->records[slot * capture_ring->record_size];
+            memcpy(record, &recordHeader, sizeof(max7219_capture_record_t));
+            memcpy(record + sizeof(max7219_capture_record_t), data, lengthInBytes);
+        portEXIT_CRITICAL(&capture_ring->lock);
+    }
+#endif
+}
+
+
+
+esp_err_t led_driver_max7219_attach_bus_coordinator(led_driver_max7219_handle_t handle, max7219_bus_coordinator_handle_t coordinator) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE(coordinator != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'coordinator' must not be NULL");
+
+    // Holding the driver mutex guarantees no operation is using the SPI bus directly while we switch
+    ESP_RETURN_ON_FALSE(take_driver_mutex_private(driver_context, portMAX_DELAY) == pdTRUE, ESP_ERR_TIMEOUT, LedDriverMax7219LogTag, "Could not acquire mutex");
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(driver_context->bus_chain == NULL, ESP_ERR_INVALID_STATE, cleanup, LedDriverMax7219LogTag, "Driver is already attached to a bus coordinator");
+
+    // The coordinator shares the bus transfer by transfer - A bus kept by the ownership policy would starve other chains. It is acquired again after detaching
+    if (driver_context->bus_held) {
+        spi_device_release_bus(driver_context->spi_device_handle);
+        driver_context->bus_held = false;
+        if (driver_context->bus_release_timer != NULL) {
+            esp_timer_stop(driver_context->bus_release_timer);
+        }
+    }
+    ret = max7219_bus_chain_attach_private(coordinator, driver_context->spi_device_handle, CHAIN_LENGTH(driver_context) * sizeof(max7219_command_t), driver_context->spi_queue_size, &driver_context->bus_chain);
+
+cleanup:
+    give_driver_mutex_private(driver_context);
+    return ret;
+}
+
+esp_err_t led_driver_max7219_detach_bus_coordinator(led_driver_max7219_handle_t handle) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+
+    ESP_RETURN_ON_FALSE(take_driver_mutex_private(driver_context, portMAX_DELAY) == pdTRUE, ESP_ERR_TIMEOUT, LedDriverMax7219LogTag, "Could not acquire mutex");
+    esp_err_t ret = ESP_OK;
+    if (driver_context->bus_chain != NULL) {
+        ret = max7219_bus_chain_detach_private(driver_context->bus_chain);
+        driver_context->bus_chain = NULL;
+    }
+    give_driver_mutex_private(driver_context);
+
+    return ret;
+}
+
+
+
+esp_err_t led_driver_max7219_compile_script(led_driver_max7219_handle_t handle, const max7219_script_step_t steps[], uint16_t stepCount, max7219_script_handle_t* script) {
+    ESP_RETURN_ON_FALSE(script != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'script' must not be NULL");
+    *script = NULL;
+
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE((steps != NULL) && (stepCount > 0), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'steps' must not be NULL or empty");
+    for (uint16_t stepIndex = 0; stepIndex < stepCount; stepIndex++) {
+        const max7219_script_step_t* step = &steps[stepIndex];
+        ESP_RETURN_ON_FALSE((step->chain_id == 0) || (check_max_chain_id_private(driver_context, step->chain_id) == ESP_OK), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "Invalid chain ID in step %u", stepIndex);
+        ESP_RETURN_ON_FALSE((step->reg <= MAX7219_REGISTER_SHUTDOWN) || (step->reg == MAX7219_REGISTER_DISPLAY_TEST), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "Invalid register in step %u", stepIndex);
+    }
+
+    // 'nextFrames[chainIndex]' is the first transfer where device 'chainIndex + 1' has no command yet - A write to all devices goes
+    // after the last transfer used by any device so writes to the same device, and writes to all devices, keep their order
+    uint16_t* nextFrames = heap_caps_calloc(CHAIN_LENGTH(driver_context), sizeof(uint16_t), MALLOC_CAP_DEFAULT);
+    if (nextFrames == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint16_t frameCount = 0;
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        memset(nextFrames, 0, CHAIN_LENGTH(driver_context) * sizeof(uint16_t));
+        for (uint16_t stepIndex = 0; stepIndex < stepCount; stepIndex++) {
+            const max7219_script_step_t* step = &steps[stepIndex];
+            if (step->reg == MAX7219_REGISTER_NOOP) {
+                continue;
+            }
+
+            uint8_t firstChainIndex = step->chain_id == 0 ? 0 : step->chain_id - 1;
+            uint8_t lastChainIndex = step->chain_id == 0 ? CHAIN_LENGTH(driver_context) - 1 : step->chain_id - 1;
+            uint16_t frameIndex = 0;
+            for (uint8_t chainIndex = firstChainIndex; chainIndex <= lastChainIndex; chainIndex++) {
+                frameIndex = nextFrames[chainIndex] > frameIndex ? nextFrames[chainIndex] : frameIndex;
+            }
+
+            for (uint8_t chainIndex = firstChainIndex; chainIndex <= lastChainIndex; chainIndex++) {
+                nextFrames[chainIndex] = frameIndex + 1;
+                if (pass == 1) {
+                    // The command for device 'chainIndex + 1' is at index 'chain_length - 1 - chainIndex' of its transfer
+                    max7219_command_t* frame = &(*script)->frames[frameIndex * CHAIN_LENGTH(driver_context)];
+                    frame[CHAIN_LENGTH(driver_context) - 1 - chainIndex] = (max7219_command_t) { .address = (max7219_address_t) step->reg, .data = step->data };
+                }
+            }
+            frameCount = frameIndex + 1 > frameCount ? frameIndex + 1 : frameCount;
+        }
+
+        // First pass - Count transfers and allocate the script. Transfers are zeroed, which is a no-op for every device
+        if ((pass == 0) && (frameCount > 0)) {
+            max7219_script_t* compiled = heap_caps_calloc(1, sizeof(max7219_script_t) + frameCount * sizeof(spi_transaction_t), MALLOC_CAP_DEFAULT);
+            max7219_command_t* frames = heap_caps_calloc(frameCount * CHAIN_LENGTH(driver_context), sizeof(max7219_command_t), MALLOC_CAP_DMA);
+            if ((compiled == NULL) || (frames == NULL)) {
+                heap_caps_free(compiled);
+                heap_caps_free(frames);
+                heap_caps_free(nextFrames);
+                return ESP_ERR_NO_MEM;
+            }
+
+            compiled->driver_context = driver_context;
+            compiled->frame_count = frameCount;
+            compiled->transactions = (spi_transaction_t*) (compiled + 1);
+            compiled->frames = frames;
+            *script = compiled;
+        }
+    }
+    heap_caps_free(nextFrames);
+
+    // A script made of no-ops only compiles to an empty script
+    if (frameCount == 0) {
+        *script = heap_caps_calloc(1, sizeof(max7219_script_t), MALLOC_CAP_DEFAULT);
+        if (*script == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        (*script)->driver_context = driver_context;
+        return ESP_OK;
+    }
+
+    for (uint16_t frameIndex = 0; frameIndex < frameCount; frameIndex++) {
+        (*script)->transactions[frameIndex] = (spi_transaction_t) {
+            .length = CHAIN_LENGTH(driver_context) * sizeof(max7219_command_t) * 8,
+            .tx_buffer = &(*script)->frames[frameIndex * CHAIN_LENGTH(driver_context)]
+        };
+    }
+    for (uint16_t stepIndex = 0; stepIndex < stepCount; stepIndex++) {
+        (*script)->writes_digits |= (steps[stepIndex].reg >= MAX7219_REGISTER_DIGIT_1) && (steps[stepIndex].reg <= MAX7219_REGISTER_DIGIT_8);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_play_script(led_driver_max7219_handle_t handle, max7219_script_handle_t script) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE((script != NULL) && (script->driver_context == driver_context), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'script' must be compiled for this driver");
+
+    return send_chain_with_callback_private(driver_context, MAX7219_LATENCY_API_PLAY_SCRIPT, send_chain_script_callback, script);
+}
+
+esp_err_t led_driver_max7219_delete_script(max7219_script_handle_t script) {
+    ESP_RETURN_ON_FALSE(script != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'script' must not be NULL");
+
+    heap_caps_free(script->frames);
+    heap_caps_free(script);
+    return ESP_OK;
+}
+
+static esp_err_t send_chain_script_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    max7219_script_t* script = (max7219_script_t*) arg;
+    if (script->writes_digits) {
+        invalidate_shown_frame_private(driver_context);
+    }
+
+    return script->frame_count > 0 ? spi_send_batch_private(driver_context, script->transactions, script->frame_count) : ESP_OK;
+}
+
+esp_err_t led_driver_max7219_send_wire_frames(led_driver_max7219_handle_t handle, const uint8_t* const frames[], uint16_t frameCount) {
+    led_driver_max7219_context_t* driver_context = NULL;
+    ACQUIRE_CONTEXT_OR_RETURN(handle);
+    ESP_RETURN_ON_ERROR(check_max_handle_private(driver_context), LedDriverMax7219LogTag, "Invalid handle");
+    ESP_RETURN_ON_FALSE((frames != NULL) || (frameCount == 0), ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "'frames' must not be NULL");
+
+    if (frameCount == 0) {
+        return ESP_OK;
+    }
+
+    chain_wire_frames_t wireFrames = { .frames = frames, .frameCount = frameCount };
+    return send_chain_with_callback_private(driver_context, MAX7219_LATENCY_API_SEND_WIRE_FRAMES, send_chain_wire_frames_callback, &wireFrames);
+}
+
+static esp_err_t send_chain_wire_frames_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    chain_wire_frames_t* wireFrames = (chain_wire_frames_t*) arg;
+    max7219_command_t* buffer = get_command_buffer_private(driver_context);
+
+    // Frames may live in flash, which SPI DMA cannot read - Each frame is copied to the command buffer as is
+    invalidate_shown_frame_private(driver_context);
+    for (uint16_t frameIndex = 0; frameIndex < wireFrames->frameCount; frameIndex++) {
+        ESP_RETURN_ON_FALSE(wireFrames->frames[frameIndex] != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LogTag, "Frame %d must not be NULL", frameIndex);
+        memcpy(buffer, wireFrames->frames[frameIndex], CHAIN_LENGTH(driver_context) * sizeof(max7219_command_t));
+        ESP_RETURN_ON_ERROR(spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context)), LedDriverMax7219LogTag, "Failed to send commands to chain");
+    }
+
+    return ESP_OK;
+}
+
+
+
+static esp_err_t send_chain_command_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, const chain_command_t* cmd) {
+    return send_chain_with_callback_private(driver_context, api, send_chain_one_command_callback, (void*)cmd);
+}
+
+static esp_err_t send_chain_with_callback_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, send_chain_callback_t send_cb, void* args) {
+    return send_chain_with_timeout_private(driver_context, api, portMAX_DELAY, send_cb, args);
+}
+
+static esp_err_t send_chain_with_timeout_private(led_driver_max7219_context_t* driver_context, max7219_latency_api_t api, TickType_t ticksToWait, send_chain_callback_t send_cb, void* args) {
+    int64_t startUs = LATENCY_TIMESTAMP();
+    if (take_driver_mutex_private(driver_context, ticksToWait) != pdTRUE) {
+        // Expected with a bounded wait - The driver is busy
+        if (ticksToWait == portMAX_DELAY) {
+            ESP_LOGE(LedDriverMax7219LogTag, "Could not acquire mutex");
+        }
+        return ESP_ERR_TIMEOUT;
+    }
+    int64_t mutexUs = LATENCY_TIMESTAMP();
+    begin_operation_latency_private(driver_context);
+
+    // Take exclusive access of the SPI bus
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_ERROR(acquire_bus_private(driver_context), cleanup, LedDriverMax7219LogTag, "Unable to acquire SPI bus");
+    int64_t busUs = LATENCY_TIMESTAMP();
+
+        // Digits staged for write combining were written before this operation and go out first
+        ret = drain_write_combiner_private(driver_context);
+        ret = ret == ESP_OK ? send_cb(driver_context, args) : ret;
+
+        // Send digits staged by other tasks (urgent / background priority) and apply the power policy while we own the bus
+        esp_err_t finishErr = finish_operation_private(driver_context);
+        ret = ret == ESP_OK ? finishErr : ret;
+
+    // Release access to the SPI bus
+    release_bus_private(driver_context);
+    record_operation_latency_private(driver_context, api, startUs, mutexUs, busUs, LATENCY_TIMESTAMP());
+
+cleanup:
+    // Release mutex
+    if (give_driver_mutex_private(driver_context) != pdTRUE) {
+        ESP_LOGE(LedDriverMax7219LogTag, "Could not release mutex - Exiting without releasing mutex which may cause a deadlock later");
+    }
+
+    // Digits staged after we drained but before we released the mutex would otherwise wait for the next operation
+    if (driver_context->priority_classes != NULL) {
+        esp_err_t drainErr = try_drain_pending_private(driver_context);
+        ret = ret == ESP_OK ? drainErr : ret;
+    }
+
+    return ret;
+}
+
+static esp_err_t send_chain_one_command_callback(led_driver_max7219_context_t* driver_context, void* arg) {
+    chain_command_t* chain_command = (chain_command_t*)arg;
+    max7219_command_t* buffer = get_command_buffer_private(driver_context);
+
+    // Digits written outside of the frame buffers make the next flush send the whole frame
+    if ((chain_command->cmd.address >= MAX7219_DIGIT0_ADDRESS) && (chain_command->cmd.address <= MAX7219_DIGIT7_ADDRESS)) {
+        invalidate_shown_frame_private(driver_context);
+    }
 
     // NOTE: chainId == 0 means broadcast to all devices, otherwise target a specific device
     if (chain_command->chainId == 0) {
@@ -520,7 +2420,7 @@ static esp_err_t send_chain_one_command_callback(led_driver_max7219_context_t* d
         ESP_LOGI(LedDriverMax7219LogTag, "Sending { address: 0x%02X, data: 0x%02X } to all devices", chain_command->cmd.address, chain_command->cmd.data);
 #endif
         // Send all devices the same .address and .data
-        for (uint8_t deviceIndex = 0; deviceIndex < driver_context->hw_config.chain_length; deviceIndex++) {
+        for (uint8_t deviceIndex = 0; deviceIndex < CHAIN_LENGTH(driver_context); deviceIndex++) {
             buffer[deviceIndex] = chain_command->cmd;
         }
     } else {
@@ -530,12 +2430,12 @@ static esp_err_t send_chain_one_command_callback(led_driver_max7219_context_t* d
         // Target a specific device in the chain - The device is given in chainId which is 1-based
         // The array is initialized to 0 which means .address is already set to MAX7219_NOOP_ADDRESS and .data is already set to 0
         // The data for the last device on the chain needs to be sent first so deviceId n is at index hw_config.chain_length - 1 in the array
-        uint8_t deviceIndex = driver_context->hw_config.chain_length - chain_command->chainId;
-        memset(buffer, 0, driver_context->hw_config.chain_length * sizeof(max7219_command_t));
+        uint8_t deviceIndex = CHAIN_LENGTH(driver_context) - chain_command->chainId;
+        memset(buffer, 0, CHAIN_LENGTH(driver_context) * sizeof(max7219_command_t));
         buffer[deviceIndex] = chain_command->cmd;
     }
 
-    return spi_send_private(driver_context, buffer, driver_context->hw_config.chain_length);
+    return spi_send_private(driver_context, buffer, CHAIN_LENGTH(driver_context));
 }
 
 static esp_err_t send_chain_command_array_callback(led_driver_max7219_context_t* driver_context, void* arg) {
@@ -553,22 +2453,183 @@ static esp_err_t send_chain_command_array_callback(led_driver_max7219_context_t*
     return ESP_OK;
 }
 
+static esp_err_t acquire_bus_private(led_driver_max7219_context_t* driver_context) {
+    // Chains attached to a bus coordinator share the bus transfer by transfer and never hold it - The ownership policy may have kept the bus from a previous operation
+    if ((driver_context->bus_chain != NULL) || driver_context->bus_held) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = spi_device_acquire_bus(driver_context->spi_device_handle, portMAX_DELAY);
+    if ((err == ESP_OK) && (driver_context->bus_ownership != MAX7219_BUS_OWNERSHIP_PER_OPERATION)) {
+        driver_context->bus_held = true;
+        if (driver_context->bus_release_timer != NULL) {
+            // Checks for idle periods until the bus is released
+            driver_context->bus_used = true;
+            err = esp_timer_start_periodic(driver_context->bus_release_timer, (uint64_t) driver_context->bus_idle_release_ms * 1000);
+            if (err != ESP_OK) {
+                spi_device_release_bus(driver_context->spi_device_handle);
+                driver_context->bus_held = false;
+            }
+        }
+    }
+    return err;
+}
+
+static void release_bus_private(led_driver_max7219_context_t* driver_context) {
+    if (driver_context->bus_chain != NULL) {
+        return;
+    }
+
+    switch (driver_context->bus_ownership) {
+        case MAX7219_BUS_OWNERSHIP_PER_OPERATION:
+            spi_device_release_bus(driver_context->spi_device_handle);
+            break;
+
+        case MAX7219_BUS_OWNERSHIP_PERSISTENT:
+            break;
+
+        case MAX7219_BUS_OWNERSHIP_IDLE_RELEASE:
+            // Back to back operations only flag the bus as used - The release timer checks the flag once per idle period
+            driver_context->bus_used = true;
+            break;
+    }
+}
+
+static void give_up_bus_private(led_driver_max7219_context_t* driver_context) {
+    // Must be called after close_timer_callbacks_private() - The release timer and the bus are given up under the driver mutex so they are released once
+    if (take_driver_mutex_private(driver_context, portMAX_DELAY) != pdTRUE) {
+        ESP_LOGE(LedDriverMax7219LogTag, "Could not acquire mutex");
+        return;
+    }
+
+    if (driver_context->bus_release_timer != NULL) {
+        esp_timer_stop(driver_context->bus_release_timer);
+        esp_timer_delete(driver_context->bus_release_timer);
+        driver_context->bus_release_timer = NULL;
+    }
+
+    if (driver_context->bus_held) {
+        spi_device_release_bus(driver_context->spi_device_handle);
+        driver_context->bus_held = false;
+    }
+
+    give_driver_mutex_private(driver_context);
+}
+
+static void bus_release_timer_callback(void* arg) {
+    led_driver_max7219_context_t* driver_context = (led_driver_max7219_context_t*) arg;
+    if (!enter_timer_callback_private(driver_context)) {
+        return;
+    }
+
+    // If the driver is busy, the operation in progress flags the bus as used
+    if (take_driver_mutex_private(driver_context, 0) == pdTRUE) {
+        // The bus is released between one and two idle periods after the last operation - Unless it was given up while this callback was pending
+        if (driver_context->bus_used) {
+            driver_context->bus_used = false;
+        } else if (driver_context->bus_held && (driver_context->bus_release_timer != NULL)) {
+            spi_device_release_bus(driver_context->spi_device_handle);
+            driver_context->bus_held = false;
+            esp_timer_stop(driver_context->bus_release_timer);
+        }
+
+        give_driver_mutex_private(driver_context);
+    }
+
+    exit_timer_callback_private(driver_context);
+}
+
 static esp_err_t spi_send_private(led_driver_max7219_context_t* driver_context, const max7219_command_t* const data, uint16_t commandsCount) {
     uint16_t lengthInBytes = sizeof(max7219_command_t) * commandsCount;
-    bool useTxData = lengthInBytes <= 4;
-    spi_transaction_t spiTransaction = {
-        .flags = useTxData ? SPI_TRANS_USE_TXDATA : 0,
-        .length = lengthInBytes * 8,
-        .rxlength = 0
-    };
-
-    if (useTxData) {
-        memcpy(spiTransaction.tx_data, data, lengthInBytes);
+    if (driver_context->bus_chain != NULL) {
+        // The coordinator owns a copy of the transfer - Errors of earlier transfers are reported here
+        int64_t transmitStartUs = TRANSFER_TIMESTAMP();
+        ESP_RETURN_ON_ERROR(max7219_bus_chain_submit_private(driver_context->bus_chain, data, lengthInBytes), LedDriverMax7219LogTag, "Failed to transmit");
+        record_transfer_private(driver_context, data, lengthInBytes, transmitStartUs, TRANSFER_TIMESTAMP());
     } else {
-        spiTransaction.tx_buffer = data;
+        bool useTxData = lengthInBytes <= 4;
+        spi_transaction_t spiTransaction = {
+            .flags = useTxData ? SPI_TRANS_USE_TXDATA : 0,
+            .length = lengthInBytes * 8,
+            .rxlength = 0
+        };
+
+        if (useTxData) {
+            memcpy(spiTransaction.tx_data, data, lengthInBytes);
+        } else {
+            spiTransaction.tx_buffer = data;
+        }
+
+        int64_t transmitStartUs = TRANSFER_TIMESTAMP();
+        ESP_RETURN_ON_ERROR(spi_device_transmit(driver_context->spi_device_handle, &spiTransaction), LedDriverMax7219LogTag, "Failed to transmit");
+        record_transfer_private(driver_context, data, lengthInBytes, transmitStartUs, TRANSFER_TIMESTAMP());
+    }
+
+    // Urgent digits go out right after the current transfer, ahead of the remaining transfers of this operation
+    // NOTE: Callers rewrite the whole command buffer for every transfer so it can be reused here
+    if ((driver_context->priority_classes != NULL) && driver_context->priority_classes->urgent.pending && !driver_context->priority_classes->draining) {
+        driver_context->priority_classes->draining = true;
+        esp_err_t err = drain_mailbox_private(driver_context, &driver_context->priority_classes->urgent, MAX7219_PRIORITY_URGENT);
+        driver_context->priority_classes->draining = false;
+        return err;
+    }
+
+    return ESP_OK;
+}
+
+
+
+static esp_err_t spi_send_batch_private(led_driver_max7219_context_t* driver_context, spi_transaction_t* transactions, uint16_t transactionsCount) {
+    // Chains attached to a bus coordinator already have their transfers queued back to back by the coordinator
+    if (driver_context->bus_chain != NULL) {
+        for (uint16_t index = 0; index < transactionsCount; index++) {
+            ESP_RETURN_ON_ERROR(spi_send_private(driver_context, transactions[index].tx_buffer, CHAIN_LENGTH(driver_context)), LedDriverMax7219LogTag, "Failed to send commands to chain");
+        }
+        return ESP_OK;
+    }
+
+    // Keep up to 'spi_queue_size' transfers queued so the SPI host moves from one transfer to the next without waiting for this task
+    // NOTE: A transfer is timed from the end of the previous one, or from the start of the batch, to the moment its result is read
+    const uint16_t queueSize = driver_context->spi_queue_size > 0 ? driver_context->spi_queue_size : 1;
+    uint16_t queued = 0;
+    uint16_t completed = 0;
+    int64_t previousEndUs = TRANSFER_TIMESTAMP();
+    esp_err_t ret = ESP_OK;
+    while ((completed < queued) || ((ret == ESP_OK) && (queued < transactionsCount))) {
+        if ((ret == ESP_OK) && (queued < transactionsCount) && (queued - completed < queueSize)) {
+            ret = spi_device_queue_trans(driver_context->spi_device_handle, &transactions[queued], portMAX_DELAY);
+            queued += ret == ESP_OK ? 1 : 0;
+            continue;
+        }
+
+        // Queued transfers must be reaped even after an error - Keep reading results and report the first error once the queue is empty
+        spi_transaction_t* transaction = NULL;
+        esp_err_t err = spi_device_get_trans_result(driver_context->spi_device_handle, &transaction, portMAX_DELAY);
+        completed++;
+        if (err != ESP_OK) {
+#if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
+            ESP_LOGE(LedDriverMax7219LogTag, "Failed to read transfer result (%d)", err);
+#endif
+            ret = ret == ESP_OK ? err : ret;
+            continue;
+        }
+
+        int64_t endUs = TRANSFER_TIMESTAMP();
+        record_transfer_private(driver_context, transaction->tx_buffer, transaction->length / 8, previousEndUs, endUs);
+        previousEndUs = endUs;
     }
 
-    return spi_device_transmit(driver_context->spi_device_handle, &spiTransaction);
+    return ret;
+}
+
+static void record_transfer_private(led_driver_max7219_context_t* driver_context, const max7219_command_t* const data, uint16_t lengthInBytes, int64_t startUs, int64_t endUs) {
+    record_transmit_latency_private(driver_context, endUs - startUs);
+    capture_transfer_private(driver_context, startUs, endUs, data, lengthInBytes);
+
+    // Keep track of what every device holds for the power policy
+    if (driver_context->power_manager != NULL) {
+        mirror_commands_private(driver_context, data);
+    }
 }
 
 
@@ -605,6 +2666,49 @@ static esp_err_t check_driver_configuration_private(const max7219_config_t* conf
         return ESP_ERR_INVALID_ARG;
     }
 
+    // Check initial state - Every device state must be valid
+    if (config->initial_state.apply) {
+        uint8_t stateCount = config->initial_state.devices != NULL ? config->hw_config.chain_length : 1;
+        for (uint8_t stateIndex = 0; stateIndex < stateCount; stateIndex++) {
+            const max7219_device_state_t* state = config->initial_state.devices != NULL ? &config->initial_state.devices[stateIndex] : &config->initial_state.chain;
+            if ((state->scan_limit < MAX7219_MIN_DIGIT) || (state->scan_limit > MAX7219_MAX_DIGIT) || (state->intensity > MAX7219_INTENSITY_DUTY_CYCLE_STEP_16) ||
+                ((state->mode != MAX7219_SHUTDOWN_MODE) && (state->mode != MAX7219_NORMAL_MODE) && (state->mode != MAX7219_TEST_MODE))) {
+#if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
+                ESP_LOGE(LedDriverMax7219LogTag, "initial_state has an invalid scan limit, intensity or mode for state %u", stateIndex);
+#endif
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+    }
+
+    // Check SPI configuration - The idle release policy needs an idle period and a release timer which runs on the esp_timer task
+    if ((config->spi_cfg.bus_ownership < MAX7219_BUS_OWNERSHIP_PER_OPERATION) || (config->spi_cfg.bus_ownership > MAX7219_BUS_OWNERSHIP_IDLE_RELEASE) ||
+        ((config->spi_cfg.bus_ownership == MAX7219_BUS_OWNERSHIP_IDLE_RELEASE) && (config->spi_cfg.bus_idle_release_ms == 0))) {
+#if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
+        ESP_LOGE(LedDriverMax7219LogTag, "spi_cfg.bus_ownership is invalid or spi_cfg.bus_idle_release_ms is 0");
+#endif
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    if (config->spi_cfg.bus_ownership == MAX7219_BUS_OWNERSHIP_IDLE_RELEASE) {
+#if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
+        ESP_LOGE(LedDriverMax7219LogTag, "MAX7219_BUS_OWNERSHIP_IDLE_RELEASE is not supported with CONFIG_MAX_7219_7221_SINGLE_OWNER");
+#endif
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+#endif
+
+#ifdef MAX7219_FIXED_CHAIN_LENGTH
+    // Check hardware configuration - Chain length must match the length this firmware was compiled for
+    if (config->hw_config.chain_length != MAX7219_FIXED_CHAIN_LENGTH) {
+#if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
+        ESP_LOGE(LedDriverMax7219LogTag, "hw_config.chain_length must be %d (CONFIG_MAX_7219_7221_FIXED_CHAIN_LENGTH)", MAX7219_FIXED_CHAIN_LENGTH);
+#endif
+        return ESP_ERR_INVALID_ARG;
+    }
+#endif
+
     return ESP_OK;
 }
 
@@ -616,18 +2720,20 @@ static esp_err_t check_max_handle_private(led_driver_max7219_context_t* driver_c
         return ESP_ERR_INVALID_STATE;
     }
 
+#if !CONFIG_MAX_7219_7221_SINGLE_OWNER
     if (driver_context->mutex == NULL) {
 #if CONFIG_MAX_7219_7221_ENABLE_DEBUG_LOG
         ESP_LOGE(LedDriverMax7219LogTag, "led_driver_max7219_init() must be called before any other function");
 #endif
         return ESP_ERR_INVALID_STATE;
     }
+#endif
 
     return ESP_OK;
 }
 
 static esp_err_t check_max_chain_id_private(led_driver_max7219_context_t* driver_context, uint8_t chainId) {
-    return (chainId >= 1) && (chainId <= driver_context->hw_config.chain_length) ? ESP_OK : ESP_ERR_INVALID_ARG;
+    return (chainId >= 1) && (chainId <= CHAIN_LENGTH(driver_context)) ? ESP_OK : ESP_ERR_INVALID_ARG;
 }
 
 static esp_err_t check_max_digit_private(led_driver_max7219_context_t* driver_context, uint8_t digit) {
@@ -636,6 +2742,6 @@ static esp_err_t check_max_digit_private(led_driver_max7219_context_t* driver_co
 
 static esp_err_t check_bulk_symbols_array_length(led_driver_max7219_context_t* driver_context, uint8_t startChainId, uint8_t startDigitId, uint16_t digitCodesCount) {
     // Number of remaining digits starting at device 'startChainId' and at digit 'startDigitId'
-    const uint16_t availableDigits = ((driver_context->hw_config.chain_length - startChainId) * MAX7219_MAX_DIGIT) + (MAX7219_MAX_DIGIT - startDigitId) + 1;
+    const uint16_t availableDigits = ((CHAIN_LENGTH(driver_context) - startChainId) * MAX7219_MAX_DIGIT) + (MAX7219_MAX_DIGIT - startDigitId) + 1;
     return (digitCodesCount > 0) && (digitCodesCount <= availableDigits) ? ESP_OK : ESP_ERR_INVALID_ARG;
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include <esp_attr.h>
+#include <esp_check.h>
+#include <esp_heap_caps.h>
+
+#include "max7219_7221_animation.h"
+
+
+DRAM_ATTR static const char* LedDriverMax7219AnimationLogTag = "leddriver_max72[19|21]_animation";
+
+#define MAX_ANIMATION_DIGITS (UINT8_MAX * MAX7219_MAX_DIGIT)
+
+#define RLE_RUN_FLAG 0x80
+#define RLE_LENGTH_MASK 0x7F
+
+
+static uint16_t read_uint16_private(const uint8_t* data);
+static esp_err_t decode_frame_private(max7219_animation_player_t* player, bool* anyChanged);
+
+
+
+esp_err_t led_driver_max7219_animation_init(max7219_animation_player_t* player, led_driver_max7219_handle_t handle, const max7219_animation_config_t* config, const uint8_t* data, size_t length) {
+    ESP_RETURN_ON_FALSE((player != NULL) && (handle != NULL) && (config != NULL) && (data != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "'player', 'handle', 'config' and 'data' must not be NULL");
+    ESP_RETURN_ON_FALSE(config->start_chain_id >= 1, ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "'start_chain_id' must be >= 1");
+    ESP_RETURN_ON_FALSE((config->start_digit_id >= MAX7219_MIN_DIGIT) && (config->start_digit_id <= MAX7219_MAX_DIGIT), ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "'start_digit_id' must be between 1 and 8");
+    ESP_RETURN_ON_FALSE(length >= MAX7219_ANIMATION_HEADER_SIZE, ESP_ERR_INVALID_VERSION, LedDriverMax7219AnimationLogTag, "'data' is too short to be an animation");
+    ESP_RETURN_ON_FALSE((data[0] == 'M') && (data[1] == '7') && (data[2] == MAX7219_ANIMATION_VERSION), ESP_ERR_INVALID_VERSION, LedDriverMax7219AnimationLogTag, "'data' is not an animation of version %d", MAX7219_ANIMATION_VERSION);
+
+    uint16_t digitCount = read_uint16_private(&data[4]);
+    uint16_t frameCount = read_uint16_private(&data[6]);
+    ESP_RETURN_ON_FALSE((digitCount >= 1) && (digitCount <= MAX_ANIMATION_DIGITS), ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "Animation frames must have between 1 and %d digits", MAX_ANIMATION_DIGITS);
+    ESP_RETURN_ON_FALSE(frameCount >= 1, ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "Animation has no frame");
+
+    memset(player, 0, sizeof(max7219_animation_player_t));
+
+    // One allocation for the frame and its changed digits
+    uint16_t changedSize = (digitCount + 7) / 8;
+    uint8_t* buffers = heap_caps_calloc(digitCount + changedSize, sizeof(uint8_t), MALLOC_CAP_DEFAULT);
+    if (buffers == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    player->handle = handle;
+    player->config = *config;
+    player->data = data;
+    player->length = length;
+    player->digit_count = digitCount;
+    player->frame_count = frameCount;
+    player->frame_ms = read_uint16_private(&data[8]);
+    player->offset = MAX7219_ANIMATION_HEADER_SIZE;
+    player->frame = buffers;
+    player->changed = buffers + digitCount;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_animation_next(max7219_animation_player_t* player, bool* finished) {
+    ESP_RETURN_ON_FALSE((player != NULL) && (player->frame != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "'player' must be initialized");
+
+    if (player->frame_index >= player->frame_count) {
+        if (!player->config.loop) {
+            if (finished != NULL) {
+                *finished = true;
+            }
+            return ESP_OK;
+        }
+        player->frame_index = 0;
+        player->offset = MAX7219_ANIMATION_HEADER_SIZE;
+    }
+
+    bool anyChanged = false;
+    esp_err_t err = decode_frame_private(player, &anyChanged);
+    if (err != ESP_OK) {
+        // The frame is partially decoded
+        player->shown_valid = false;
+        return err;
+    }
+    player->frame_index++;
+
+    if (!player->shown_valid) {
+        memset(player->changed, 0xFF, (player->digit_count + 7) / 8);
+        anyChanged = true;
+    }
+
+    if (anyChanged) {
+        // Until the digits are sent, the display content is unknown
+        player->shown_valid = false;
+        ESP_RETURN_ON_ERROR(led_driver_max7219_set_changed_digits(player->handle, player->config.start_chain_id, player->config.start_digit_id, player->frame, player->digit_count, player->changed), LedDriverMax7219AnimationLogTag, "Failed to send animation frame");
+        player->shown_valid = true;
+    }
+
+    if (finished != NULL) {
+        *finished = !player->config.loop && (player->frame_index >= player->frame_count);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_animation_rewind(max7219_animation_player_t* player) {
+    ESP_RETURN_ON_FALSE((player != NULL) && (player->frame != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "'player' must be initialized");
+
+    player->frame_index = 0;
+    player->offset = MAX7219_ANIMATION_HEADER_SIZE;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_animation_invalidate(max7219_animation_player_t* player) {
+    ESP_RETURN_ON_FALSE(player != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "'player' must not be NULL");
+
+    player->shown_valid = false;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_animation_deinit(max7219_animation_player_t* player) {
+    ESP_RETURN_ON_FALSE(player != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219AnimationLogTag, "'player' must not be NULL");
+
+    heap_caps_free(player->frame);
+    memset(player, 0, sizeof(max7219_animation_player_t));
+    return ESP_OK;
+}
+
+
+
+static uint16_t read_uint16_private(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+}
+
+static esp_err_t decode_frame_private(max7219_animation_player_t* player, bool* anyChanged) {
+    const uint8_t* data = player->data;
+    size_t offset = player->offset;
+
+    ESP_RETURN_ON_FALSE(offset < player->length, ESP_ERR_INVALID_SIZE, LedDriverMax7219AnimationLogTag, "Frame %d is truncated", player->frame_index);
+    uint8_t type = data[offset++];
+    ESP_RETURN_ON_FALSE((type == MAX7219_ANIMATION_KEY_FRAME) || ((type == MAX7219_ANIMATION_DELTA_FRAME) && (player->frame_index > 0)), ESP_ERR_INVALID_SIZE, LedDriverMax7219AnimationLogTag, "Frame %d has an invalid type", player->frame_index);
+    bool delta = type == MAX7219_ANIMATION_DELTA_FRAME;
+
+    memset(player->changed, 0, (player->digit_count + 7) / 8);
+    uint16_t digitIndex = 0;
+    while (digitIndex < player->digit_count) {
+        ESP_RETURN_ON_FALSE(offset < player->length, ESP_ERR_INVALID_SIZE, LedDriverMax7219AnimationLogTag, "Frame %d is truncated", player->frame_index);
+        uint8_t token = data[offset++];
+        uint16_t count = (token & RLE_LENGTH_MASK) + 1;
+        bool run = (token & RLE_RUN_FLAG) != 0;
+        ESP_RETURN_ON_FALSE(digitIndex + count <= player->digit_count, ESP_ERR_INVALID_SIZE, LedDriverMax7219AnimationLogTag, "Frame %d has too many digits", player->frame_index);
+        ESP_RETURN_ON_FALSE(offset + (run ? 1 : count) <= player->length, ESP_ERR_INVALID_SIZE, LedDriverMax7219AnimationLogTag, "Frame %d is truncated", player->frame_index);
+
+        // Runs of unchanged digits in delta frames are skipped without touching the frame
+        if (run && delta && (data[offset] == 0)) {
+            digitIndex += count;
+            offset++;
+            continue;
+        }
+
+        for (uint16_t index = 0; index < count; index++, digitIndex++) {
+            uint8_t value = run ? data[offset] : data[offset + index];
+            uint8_t code = delta ? player->frame[digitIndex] ^ value : value;
+            if (code != player->frame[digitIndex]) {
+                player->frame[digitIndex] = code;
+                player->changed[digitIndex / 8] |= 1 << (digitIndex % 8);
+                *anyChanged = true;
+            }
+        }
+        offset += run ? 1 : count;
+    }
+
+    player->offset = offset;
+    return ESP_OK;
+}
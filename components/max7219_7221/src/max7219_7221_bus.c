@@ -0,0 +1,310 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_attr.h>
+#include <esp_check.h>
+
+#include "max7219_7221.h"
+#include "max7219_7221_bus.h"
+
+
+DRAM_ATTR static const char* LedDriverMax7219BusLogTag = "leddriver_max72[19|21]_bus";
+
+
+// One per attached chain - Frames move through the ring in order:
+//  * The driver writes frame 'head' after taking a 'free_slots' count, then increments 'pending',
+//  * The coordinator queues frame 'tail' to the SPI host, moving it from 'pending' to 'in_flight',
+//  * The coordinator gives a 'free_slots' count back when the transfer completes
+struct max7219_bus_chain {
+    max7219_bus_coordinator_handle_t coordinator;
+    spi_device_handle_t spi_device_handle;
+    uint16_t frame_length;
+    uint8_t depth;
+    uint8_t max_in_flight;
+    uint8_t head;
+    uint8_t tail;
+    uint8_t pending;
+    uint8_t in_flight;
+    esp_err_t deferred_error;
+    SemaphoreHandle_t free_slots;
+    spi_transaction_t* transactions;
+    uint8_t* frames;
+};
+
+// Chains are served round robin, one frame per chain per turn, so a chain sending many frames cannot starve the others
+// Transfers are reaped in the order they were queued - 'in_flight' is a FIFO of the chains owning queued transfers
+struct max7219_bus_coordinator {
+    max7219_bus_coordinator_config_t config;
+    portMUX_TYPE lock;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped;
+    volatile bool stopping;
+    uint8_t chain_count;
+    uint8_t next_chain;
+    uint8_t in_flight_head;
+    uint8_t in_flight_count;
+    max7219_bus_chain_t** chains;
+    max7219_bus_chain_t** in_flight;
+};
+
+
+static void bus_coordinator_task(void* arg);
+static max7219_bus_chain_t* reserve_next_frame_private(max7219_bus_coordinator_handle_t coordinator, uint8_t* slot);
+static void complete_frame_private(max7219_bus_chain_t* chain, esp_err_t err);
+static void free_bus_chain_private(max7219_bus_chain_t* chain);
+
+
+
+esp_err_t led_driver_max7219_bus_coordinator_create(const max7219_bus_coordinator_config_t* config, max7219_bus_coordinator_handle_t* coordinator) {
+    ESP_RETURN_ON_FALSE(coordinator != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219BusLogTag, "'coordinator' must not be NULL");
+
+    // Always clear return values even if we later fail
+    *coordinator = NULL;
+
+    ESP_RETURN_ON_FALSE(config != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219BusLogTag, "'config' must not be NULL");
+    ESP_RETURN_ON_FALSE(config->max_chains > 0, ESP_ERR_INVALID_ARG, LedDriverMax7219BusLogTag, "'max_chains' must be > 0");
+    ESP_RETURN_ON_FALSE(config->frames_per_chain > 0, ESP_ERR_INVALID_ARG, LedDriverMax7219BusLogTag, "'frames_per_chain' must be > 0");
+    ESP_RETURN_ON_FALSE(config->max_in_flight > 0, ESP_ERR_INVALID_ARG, LedDriverMax7219BusLogTag, "'max_in_flight' must be > 0");
+
+    // One allocation for the coordinator, the chain table and the in flight FIFO
+    max7219_bus_coordinator_handle_t pCoordinator = heap_caps_calloc(1, sizeof(struct max7219_bus_coordinator) + (config->max_chains + config->max_in_flight) * sizeof(max7219_bus_chain_t*), MALLOC_CAP_DEFAULT);
+    if (pCoordinator == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+    pCoordinator->config = *config;
+    portMUX_INITIALIZE(&pCoordinator->lock);
+    pCoordinator->chains = (max7219_bus_chain_t**) (pCoordinator + 1);
+    pCoordinator->in_flight = pCoordinator->chains + config->max_chains;
+
+    pCoordinator->stopped = xSemaphoreCreateBinaryWithCaps(MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(pCoordinator->stopped != NULL, ESP_ERR_NO_MEM, cleanup, LedDriverMax7219BusLogTag, "Could not allocate memory for semaphore");
+
+    BaseType_t created = xTaskCreatePinnedToCore(bus_coordinator_task, "max7219_bus", config->task_stack_size, pCoordinator, config->task_priority, &pCoordinator->task, config->task_core_id);
+    ESP_GOTO_ON_FALSE(created == pdPASS, ESP_ERR_NO_MEM, cleanup, LedDriverMax7219BusLogTag, "Could not create coordinator task");
+
+    *coordinator = pCoordinator;
+    return ESP_OK;
+
+cleanup:
+    if (pCoordinator->stopped != NULL) {
+        vSemaphoreDeleteWithCaps(pCoordinator->stopped);
+    }
+    heap_caps_free(pCoordinator);
+    return ret;
+}
+
+esp_err_t led_driver_max7219_bus_coordinator_delete(max7219_bus_coordinator_handle_t coordinator) {
+    ESP_RETURN_ON_FALSE(coordinator != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219BusLogTag, "'coordinator' must not be NULL");
+
+    portENTER_CRITICAL(&coordinator->lock);
+        uint8_t chainCount = coordinator->chain_count;
+    portEXIT_CRITICAL(&coordinator->lock);
+    ESP_RETURN_ON_FALSE(chainCount == 0, ESP_ERR_INVALID_STATE, LedDriverMax7219BusLogTag, "Chains are still attached to the coordinator");
+
+    // The task exits once every queued transfer completed
+    coordinator->stopping = true;
+    xTaskNotifyGive(coordinator->task);
+    xSemaphoreTake(coordinator->stopped, portMAX_DELAY);
+
+    vSemaphoreDeleteWithCaps(coordinator->stopped);
+    heap_caps_free(coordinator);
+    return ESP_OK;
+}
+
+
+
+esp_err_t max7219_bus_chain_attach_private(max7219_bus_coordinator_handle_t coordinator, spi_device_handle_t spiDeviceHandle, uint16_t frameLength, int queueSize, max7219_bus_chain_t** chain) {
+    *chain = NULL;
+
+    // One allocation for the chain and its transactions - Frames are sent via DMA and allocated separately
+    const uint8_t depth = coordinator->config.frames_per_chain;
+    max7219_bus_chain_t* pChain = heap_caps_calloc(1, sizeof(max7219_bus_chain_t) + depth * sizeof(spi_transaction_t), MALLOC_CAP_DEFAULT);
+    if (pChain == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+    pChain->coordinator = coordinator;
+    pChain->spi_device_handle = spiDeviceHandle;
+    pChain->frame_length = frameLength;
+    pChain->depth = depth;
+    pChain->transactions = (spi_transaction_t*) (pChain + 1);
+
+    // Never queue more transfers for one device than its SPI queue holds, so queuing to the SPI host does not block the coordinator
+    pChain->max_in_flight = queueSize < depth ? (queueSize < 1 ? 1 : (uint8_t) queueSize) : depth;
+
+    pChain->frames = heap_caps_calloc(depth, frameLength, MALLOC_CAP_DMA);
+    ESP_GOTO_ON_FALSE(pChain->frames != NULL, ESP_ERR_NO_MEM, cleanup, LedDriverMax7219BusLogTag, "Could not allocate memory for frame ring");
+
+    pChain->free_slots = xSemaphoreCreateCountingWithCaps(depth, depth, MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(pChain->free_slots != NULL, ESP_ERR_NO_MEM, cleanup, LedDriverMax7219BusLogTag, "Could not allocate memory for semaphore");
+
+    bool attached = false;
+    portENTER_CRITICAL(&coordinator->lock);
+        if (!coordinator->stopping && (coordinator->chain_count < coordinator->config.max_chains)) {
+            coordinator->chains[coordinator->chain_count++] = pChain;
+            attached = true;
+        }
+    portEXIT_CRITICAL(&coordinator->lock);
+    ESP_GOTO_ON_FALSE(attached, ESP_ERR_NO_MEM, cleanup, LedDriverMax7219BusLogTag, "Coordinator already serves 'max_chains' chains");
+
+    *chain = pChain;
+    return ESP_OK;
+
+cleanup:
+    free_bus_chain_private(pChain);
+    return ret;
+}
+
+esp_err_t max7219_bus_chain_submit_private(max7219_bus_chain_t* chain, const void* frame, uint16_t length) {
+    if (xSemaphoreTake(chain->free_slots, portMAX_DELAY) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // 'head' is only used by the driver, under the driver mutex
+    uint8_t slot = chain->head;
+    chain->head = (slot + 1) % chain->depth;
+
+    uint8_t* slotFrame = &chain->frames[slot * chain->frame_length];
+    memcpy(slotFrame, frame, length);
+
+    bool useTxData = length <= 4;
+    spi_transaction_t* spiTransaction = &chain->transactions[slot];
+    memset(spiTransaction, 0, sizeof(spi_transaction_t));
+    spiTransaction->flags = useTxData ? SPI_TRANS_USE_TXDATA : 0;
+    spiTransaction->length = length * 8;
+    if (useTxData) {
+        memcpy(spiTransaction->tx_data, frame, length);
+    } else {
+        spiTransaction->tx_buffer = slotFrame;
+    }
+
+    max7219_bus_coordinator_handle_t coordinator = chain->coordinator;
+    portENTER_CRITICAL(&coordinator->lock);
+        chain->pending++;
+        esp_err_t err = chain->deferred_error;
+        chain->deferred_error = ESP_OK;
+    portEXIT_CRITICAL(&coordinator->lock);
+
+    xTaskNotifyGive(coordinator->task);
+    return err;
+}
+
+esp_err_t max7219_bus_chain_detach_private(max7219_bus_chain_t* chain) {
+    // Owning every slot means every submitted transfer completed
+    for (uint8_t slot = 0; slot < chain->depth; slot++) {
+        xSemaphoreTake(chain->free_slots, portMAX_DELAY);
+    }
+
+    max7219_bus_coordinator_handle_t coordinator = chain->coordinator;
+    portENTER_CRITICAL(&coordinator->lock);
+        for (uint8_t chainIndex = 0; chainIndex < coordinator->chain_count; chainIndex++) {
+            if (coordinator->chains[chainIndex] == chain) {
+                coordinator->chains[chainIndex] = coordinator->chains[--coordinator->chain_count];
+                break;
+            }
+        }
+        coordinator->next_chain = 0;
+        esp_err_t err = chain->deferred_error;
+    portEXIT_CRITICAL(&coordinator->lock);
+
+    free_bus_chain_private(chain);
+    return err;
+}
+
+static void free_bus_chain_private(max7219_bus_chain_t* chain) {
+    if (chain->free_slots != NULL) {
+        vSemaphoreDeleteWithCaps(chain->free_slots);
+    }
+    if (chain->frames != NULL) {
+        heap_caps_free(chain->frames);
+    }
+    heap_caps_free(chain);
+}
+
+
+
+static void bus_coordinator_task(void* arg) {
+    max7219_bus_coordinator_handle_t coordinator = (max7219_bus_coordinator_handle_t) arg;
+
+    while (!coordinator->stopping || (coordinator->in_flight_count > 0)) {
+        // Keep up to 'max_in_flight' transfers queued so the SPI host moves from one chain to the next without waiting for this task
+        while (coordinator->in_flight_count < coordinator->config.max_in_flight) {
+            uint8_t slot = 0;
+            max7219_bus_chain_t* chain = reserve_next_frame_private(coordinator, &slot);
+            if (chain == NULL) {
+                break;
+            }
+
+            esp_err_t err = spi_device_queue_trans(chain->spi_device_handle, &chain->transactions[slot], portMAX_DELAY);
+            if (err != ESP_OK) {
+                complete_frame_private(chain, err);
+                continue;
+            }
+
+            coordinator->in_flight[(coordinator->in_flight_head + coordinator->in_flight_count) % coordinator->config.max_in_flight] = chain;
+            coordinator->in_flight_count++;
+        }
+
+        if (coordinator->in_flight_count == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // Reap the oldest transfer - Transfers of one device complete in the order they were queued
+        max7219_bus_chain_t* chain = coordinator->in_flight[coordinator->in_flight_head];
+        coordinator->in_flight_head = (coordinator->in_flight_head + 1) % coordinator->config.max_in_flight;
+        coordinator->in_flight_count--;
+
+        spi_transaction_t* spiTransaction = NULL;
+        esp_err_t err = spi_device_get_trans_result(chain->spi_device_handle, &spiTransaction, portMAX_DELAY);
+        complete_frame_private(chain, err);
+    }
+
+    xSemaphoreGive(coordinator->stopped);
+    vTaskDelete(NULL);
+}
+
+static max7219_bus_chain_t* reserve_next_frame_private(max7219_bus_coordinator_handle_t coordinator, uint8_t* slot) {
+    max7219_bus_chain_t* chain = NULL;
+    portENTER_CRITICAL(&coordinator->lock);
+        for (uint8_t turn = 0; turn < coordinator->chain_count; turn++) {
+            uint8_t chainIndex = (coordinator->next_chain + turn) % coordinator->chain_count;
+            max7219_bus_chain_t* candidate = coordinator->chains[chainIndex];
+            if ((candidate->pending > 0) && (candidate->in_flight < candidate->max_in_flight)) {
+                *slot = candidate->tail;
+                candidate->tail = (candidate->tail + 1) % candidate->depth;
+                candidate->pending--;
+                candidate->in_flight++;
+                coordinator->next_chain = (chainIndex + 1) % coordinator->chain_count;
+                chain = candidate;
+                break;
+            }
+        }
+    portEXIT_CRITICAL(&coordinator->lock);
+    return chain;
+}
+
+static void complete_frame_private(max7219_bus_chain_t* chain, esp_err_t err) {
+    max7219_bus_coordinator_handle_t coordinator = chain->coordinator;
+    portENTER_CRITICAL(&coordinator->lock);
+        chain->in_flight--;
+        if ((err != ESP_OK) && (chain->deferred_error == ESP_OK)) {
+            chain->deferred_error = err;
+        }
+    portEXIT_CRITICAL(&coordinator->lock);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(LedDriverMax7219BusLogTag, "Failed to transmit (%d)", err);
+    }
+
+    xSemaphoreGive(chain->free_slots);
+}
@@ -0,0 +1,34 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <driver/spi_master.h>
+
+#include "max7219_7221.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Private interface between the driver and the shared bus coordinator - Not part of the public API
+
+typedef struct max7219_bus_chain max7219_bus_chain_t;
+
+// Register an SPI device with a coordinator - 'frameLength' is the size in bytes of one chain transfer
+esp_err_t max7219_bus_chain_attach_private(max7219_bus_coordinator_handle_t coordinator, spi_device_handle_t spiDeviceHandle, uint16_t frameLength, int queueSize, max7219_bus_chain_t** chain);
+
+// Copy one chain transfer to the chain frame ring - Blocks while the ring is full. Returns the first error, if any, of transfers completed since the last call
+esp_err_t max7219_bus_chain_submit_private(max7219_bus_chain_t* chain, const void* frame, uint16_t length);
+
+// Wait until every transfer submitted for the chain completed, unregister the chain and release its memory. Returns the first error, if any, of outstanding transfers
+esp_err_t max7219_bus_chain_detach_private(max7219_bus_chain_t* chain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,607 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include <esp_attr.h>
+#include <esp_check.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include "max7219_7221_canvas.h"
+
+
+DRAM_ATTR static const char* LedDriverMax7219CanvasLogTag = "leddriver_max72[19|21]_canvas";
+
+#define MODULE_COUNT(canvas) ((uint16_t) (canvas)->config.modules_per_row * (canvas)->config.module_rows)
+
+
+static int16_t sprite_index_private(const max7219_canvas_t* canvas, const max7219_sprite_t* sprite);
+static void mark_rect_dirty_private(max7219_canvas_t* canvas, int32_t x, int32_t y, int32_t width, int32_t height);
+static void mark_sprite_dirty_private(max7219_canvas_t* canvas, const max7219_sprite_t* sprite);
+static uint8_t span_mask_private(int32_t first, int32_t last);
+static uint8_t bitmap_row_mask_private(uint8_t width, int32_t offset);
+static uint8_t bitmap_row_bits_private(const uint8_t* bitmapRow, uint8_t width, int32_t offset);
+static uint8_t sprite_row_bits_private(const max7219_sprite_t* sprite, int32_t y, int32_t moduleX);
+static void combine_byte_private(max7219_canvas_t* canvas, int32_t y, int32_t byteIndex, uint8_t bits, uint8_t mask, max7219_draw_mode_t mode);
+static void draw_pixel_private(max7219_canvas_t* canvas, int32_t x, int32_t y, max7219_draw_mode_t mode);
+static void draw_span_private(max7219_canvas_t* canvas, int32_t x0, int32_t x1, int32_t y, max7219_draw_mode_t mode);
+static void fill_bytes_private(max7219_canvas_t* canvas, int32_t y, int32_t firstByte, int32_t lastByte, max7219_draw_mode_t mode);
+static void draw_vertical_private(max7219_canvas_t* canvas, int32_t x, int32_t y0, int32_t y1, max7219_draw_mode_t mode);
+static uint8_t compose_row_private(const max7219_canvas_t* canvas, uint8_t moduleColumn, uint8_t moduleRow, uint8_t row);
+
+
+
+esp_err_t led_driver_max7219_canvas_init(max7219_canvas_t* canvas, led_driver_max7219_handle_t handle, const max7219_canvas_config_t* config) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (handle != NULL) && (config != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas', 'handle' and 'config' must not be NULL");
+    ESP_RETURN_ON_FALSE(config->start_chain_id >= 1, ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'start_chain_id' must be >= 1");
+    ESP_RETURN_ON_FALSE((config->modules_per_row >= 1) && (config->module_rows >= 1), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'modules_per_row' and 'module_rows' must be >= 1");
+    ESP_RETURN_ON_FALSE(config->start_chain_id - 1 + (uint16_t) config->modules_per_row * config->module_rows <= UINT8_MAX, ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "The canvas does not fit on the chain");
+
+    memset(canvas, 0, sizeof(max7219_canvas_t));
+    canvas->handle = handle;
+    canvas->config = *config;
+    canvas->width = config->modules_per_row * 8;
+    canvas->height = config->module_rows * 8;
+
+    // One allocation for pixels, dirty rows, rows on display and orientations - The canvas starts blank with every row to send
+    uint16_t moduleCount = MODULE_COUNT(canvas);
+    uint8_t* buffers = heap_caps_calloc(moduleCount * (8 + 1 + 8 + 1), sizeof(uint8_t), MALLOC_CAP_DEFAULT);
+    if (buffers == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    canvas->pixels = buffers;
+    canvas->dirty = buffers + moduleCount * 8;
+    canvas->shown = canvas->dirty + moduleCount;
+    canvas->orientations = canvas->shown + moduleCount * 8;
+    memset(canvas->dirty, 0xFF, moduleCount);
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_deinit(max7219_canvas_t* canvas) {
+    ESP_RETURN_ON_FALSE(canvas != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must not be NULL");
+
+    heap_caps_free(canvas->pixels);
+    memset(canvas, 0, sizeof(max7219_canvas_t));
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_clear(max7219_canvas_t* canvas) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+
+    memset(canvas->pixels, 0, MODULE_COUNT(canvas) * 8);
+    memset(canvas->dirty, 0xFF, MODULE_COUNT(canvas));
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_set_pixel(max7219_canvas_t* canvas, int16_t x, int16_t y, bool on) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+
+    if ((x < 0) || (y < 0) || (x >= canvas->width) || (y >= canvas->height)) {
+        return ESP_OK;
+    }
+
+    uint8_t* pixels = &canvas->pixels[y * canvas->config.modules_per_row + x / 8];
+    uint8_t bit = 0x80 >> (x % 8);
+    if (((*pixels & bit) != 0) != on) {
+        *pixels ^= bit;
+        canvas->dirty[(y / 8) * canvas->config.modules_per_row + x / 8] |= 1 << (y % 8);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_mark_dirty(max7219_canvas_t* canvas, int16_t x, int16_t y, uint16_t width, uint16_t height) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+
+    mark_rect_dirty_private(canvas, x, y, width, height);
+    return ESP_OK;
+}
+
+
+
+esp_err_t led_driver_max7219_canvas_draw_line(max7219_canvas_t* canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, max7219_draw_mode_t mode) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((mode == MAX7219_DRAW_OR) || (mode == MAX7219_DRAW_XOR) || (mode == MAX7219_DRAW_CLEAR), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "Invalid mode for a shape");
+
+    // Horizontal and vertical lines are spans
+    if (y0 == y1) {
+        draw_span_private(canvas, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, mode);
+        return ESP_OK;
+    }
+    if (x0 == x1) {
+        draw_vertical_private(canvas, x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, mode);
+        return ESP_OK;
+    }
+
+    // Bresenham - Every pixel is visited once so XOR lines are drawn correctly
+    int32_t dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int32_t dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int32_t stepX = x0 < x1 ? 1 : -1;
+    int32_t stepY = y0 < y1 ? 1 : -1;
+    int32_t error = dx + dy;
+    int32_t x = x0;
+    int32_t y = y0;
+    for (;;) {
+        draw_pixel_private(canvas, x, y, mode);
+        if ((x == x1) && (y == y1)) {
+            break;
+        }
+
+        int32_t doubleError = 2 * error;
+        if (doubleError >= dy) {
+            error += dy;
+            x += stepX;
+        }
+        if (doubleError <= dx) {
+            error += dx;
+            y += stepY;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_draw_rect(max7219_canvas_t* canvas, int16_t x, int16_t y, uint16_t width, uint16_t height, max7219_draw_mode_t mode) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((mode == MAX7219_DRAW_OR) || (mode == MAX7219_DRAW_XOR) || (mode == MAX7219_DRAW_CLEAR), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "Invalid mode for a shape");
+
+    if ((width == 0) || (height == 0)) {
+        return ESP_OK;
+    }
+
+    // Sides do not overlap corners so XOR rectangles are drawn correctly
+    int32_t right = x + width - 1;
+    int32_t bottom = y + height - 1;
+    draw_span_private(canvas, x, right, y, mode);
+    if (height > 1) {
+        draw_span_private(canvas, x, right, bottom, mode);
+        draw_vertical_private(canvas, x, y + 1, bottom - 1, mode);
+        if (width > 1) {
+            draw_vertical_private(canvas, right, y + 1, bottom - 1, mode);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_fill_rect(max7219_canvas_t* canvas, int16_t x, int16_t y, uint16_t width, uint16_t height, max7219_draw_mode_t mode) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((mode == MAX7219_DRAW_OR) || (mode == MAX7219_DRAW_XOR) || (mode == MAX7219_DRAW_CLEAR), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "Invalid mode for a shape");
+
+    int32_t top = y < 0 ? 0 : y;
+    int32_t bottom = y + height > canvas->height ? canvas->height : y + height;
+    for (int32_t row = top; row < bottom; row++) {
+        draw_span_private(canvas, x, x + width - 1, row, mode);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_draw_circle(max7219_canvas_t* canvas, int16_t centerX, int16_t centerY, uint16_t radius, max7219_draw_mode_t mode) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((mode == MAX7219_DRAW_OR) || (mode == MAX7219_DRAW_XOR) || (mode == MAX7219_DRAW_CLEAR), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "Invalid mode for a shape");
+
+    if (radius == 0) {
+        draw_pixel_private(canvas, centerX, centerY, mode);
+        return ESP_OK;
+    }
+
+    // Midpoint circle - Points on the axes and on the diagonals are shared by octants and drawn once so XOR circles are drawn correctly
+    draw_pixel_private(canvas, centerX, centerY - radius, mode);
+    draw_pixel_private(canvas, centerX, centerY + radius, mode);
+    draw_pixel_private(canvas, centerX - radius, centerY, mode);
+    draw_pixel_private(canvas, centerX + radius, centerY, mode);
+
+    int32_t x = 0;
+    int32_t y = radius;
+    int32_t decision = 1 - (int32_t) radius;
+    while (x < y) {
+        x++;
+        if (decision < 0) {
+            decision += 2 * x + 1;
+        } else {
+            y--;
+            decision += 2 * (x - y) + 1;
+        }
+
+        if (x < y) {
+            draw_pixel_private(canvas, centerX + x, centerY + y, mode);
+            draw_pixel_private(canvas, centerX - x, centerY + y, mode);
+            draw_pixel_private(canvas, centerX + x, centerY - y, mode);
+            draw_pixel_private(canvas, centerX - x, centerY - y, mode);
+            draw_pixel_private(canvas, centerX + y, centerY + x, mode);
+            draw_pixel_private(canvas, centerX - y, centerY + x, mode);
+            draw_pixel_private(canvas, centerX + y, centerY - x, mode);
+            draw_pixel_private(canvas, centerX - y, centerY - x, mode);
+        } else if (x == y) {
+            draw_pixel_private(canvas, centerX + x, centerY + y, mode);
+            draw_pixel_private(canvas, centerX - x, centerY + y, mode);
+            draw_pixel_private(canvas, centerX + x, centerY - y, mode);
+            draw_pixel_private(canvas, centerX - x, centerY - y, mode);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_blit(max7219_canvas_t* canvas, int16_t x, int16_t y, const uint8_t* bitmap, uint8_t width, uint8_t height, max7219_draw_mode_t mode) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((bitmap != NULL) || (width == 0) || (height == 0), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'bitmap' must not be NULL");
+    ESP_RETURN_ON_FALSE((mode >= MAX7219_DRAW_OR) && (mode <= MAX7219_DRAW_CLEAR), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "Invalid mode");
+
+    // Visible part of the bitmap - 'right' and 'bottom' are exclusive
+    int32_t left = x < 0 ? 0 : x;
+    int32_t top = y < 0 ? 0 : y;
+    int32_t right = x + width > canvas->width ? canvas->width : x + width;
+    int32_t bottom = y + height > canvas->height ? canvas->height : y + height;
+    if ((left >= right) || (top >= bottom)) {
+        return ESP_OK;
+    }
+
+    // Combine a whole canvas byte, eight pixels of one module row, at a time
+    const uint16_t bitmapStride = (width + 7) / 8;
+    for (int32_t row = top; row < bottom; row++) {
+        const uint8_t* bitmapRow = &bitmap[(row - y) * bitmapStride];
+        for (int32_t byteIndex = left / 8; byteIndex <= (right - 1) / 8; byteIndex++) {
+            int32_t offset = byteIndex * 8 - x;
+            combine_byte_private(canvas, row, byteIndex, bitmap_row_bits_private(bitmapRow, width, offset), bitmap_row_mask_private(width, offset), mode);
+        }
+    }
+    return ESP_OK;
+}
+
+
+
+esp_err_t led_driver_max7219_canvas_set_orientation(max7219_canvas_t* canvas, uint8_t chainId, max7219_orientation_t orientation) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((chainId == 0) || ((chainId >= canvas->config.start_chain_id) && (chainId - canvas->config.start_chain_id < MODULE_COUNT(canvas))), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'chainId' must show a module of this canvas");
+    ESP_RETURN_ON_FALSE((orientation & ~MAX7219_ORIENTATION_ANTI_TRANSPOSE) == 0, ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "Invalid orientation");
+
+    uint16_t firstModule = chainId == 0 ? 0 : chainId - canvas->config.start_chain_id;
+    uint16_t lastModule = chainId == 0 ? MODULE_COUNT(canvas) - 1 : firstModule;
+    for (uint16_t moduleIndex = firstModule; moduleIndex <= lastModule; moduleIndex++) {
+        if (canvas->orientations[moduleIndex] != orientation) {
+            canvas->orientations[moduleIndex] = orientation;
+            canvas->dirty[moduleIndex] = 0xFF;
+        }
+    }
+    return ESP_OK;
+}
+
+
+
+esp_err_t led_driver_max7219_canvas_add_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((sprite != NULL) && ((sprite->bitmap != NULL) || (sprite->width == 0) || (sprite->height == 0)), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'sprite' must not be NULL and must have a bitmap");
+    ESP_RETURN_ON_FALSE(sprite_index_private(canvas, sprite) < 0, ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'sprite' is already on this canvas");
+    ESP_RETURN_ON_FALSE(canvas->sprite_count < MAX7219_CANVAS_MAX_SPRITES, ESP_ERR_NO_MEM, LedDriverMax7219CanvasLogTag, "A canvas holds up to %d sprites", MAX7219_CANVAS_MAX_SPRITES);
+
+    canvas->sprites[canvas->sprite_count++] = sprite;
+    mark_sprite_dirty_private(canvas, sprite);
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_remove_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL) && (sprite != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized and 'sprite' must not be NULL");
+
+    int16_t index = sprite_index_private(canvas, sprite);
+    if (index < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    mark_sprite_dirty_private(canvas, sprite);
+    memmove(&canvas->sprites[index], &canvas->sprites[index + 1], (canvas->sprite_count - index - 1) * sizeof(max7219_sprite_t*));
+    canvas->sprite_count--;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_move_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite, int16_t x, int16_t y) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL) && (sprite_index_private(canvas, sprite) >= 0), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'sprite' must be on an initialized canvas");
+
+    if ((sprite->x != x) || (sprite->y != y)) {
+        // Redraw where the sprite was and where it goes
+        mark_sprite_dirty_private(canvas, sprite);
+        sprite->x = x;
+        sprite->y = y;
+        mark_sprite_dirty_private(canvas, sprite);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_show_sprite(max7219_canvas_t* canvas, max7219_sprite_t* sprite, bool visible) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL) && (sprite_index_private(canvas, sprite) >= 0), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'sprite' must be on an initialized canvas");
+
+    if (sprite->visible != visible) {
+        sprite->visible = visible;
+        mark_rect_dirty_private(canvas, sprite->x, sprite->y, sprite->width, sprite->height);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_set_sprite_bitmap(max7219_canvas_t* canvas, max7219_sprite_t* sprite, const uint8_t* bitmap, uint8_t width, uint8_t height) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL) && (sprite_index_private(canvas, sprite) >= 0), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'sprite' must be on an initialized canvas");
+    ESP_RETURN_ON_FALSE((bitmap != NULL) || (width == 0) || (height == 0), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'bitmap' must not be NULL");
+
+    mark_sprite_dirty_private(canvas, sprite);
+    sprite->bitmap = bitmap;
+    sprite->width = width;
+    sprite->height = height;
+    mark_sprite_dirty_private(canvas, sprite);
+    return ESP_OK;
+}
+
+
+
+esp_err_t led_driver_max7219_canvas_flush(max7219_canvas_t* canvas) {
+    return led_driver_max7219_canvas_flush_timeout(canvas, portMAX_DELAY);
+}
+
+esp_err_t led_driver_max7219_canvas_flush_timeout(max7219_canvas_t* canvas, TickType_t ticksToWait) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+
+    // Recomposite dirty rows and keep, in 'dirty', only rows which differ from the display - 'shown' then holds the rows to display
+    bool changed = false;
+    for (uint8_t moduleRow = 0; moduleRow < canvas->config.module_rows; moduleRow++) {
+        for (uint8_t moduleColumn = 0; moduleColumn < canvas->config.modules_per_row; moduleColumn++) {
+            uint16_t moduleIndex = moduleRow * canvas->config.modules_per_row + moduleColumn;
+            uint8_t dirtyRows = canvas->shown_valid ? canvas->dirty[moduleIndex] : 0xFF;
+            // Rows left by a flush which timed out differ from the display even when they match 'shown'
+            uint8_t changedRows = !canvas->shown_valid ? 0xFF : (canvas->shown_unsent ? canvas->dirty[moduleIndex] : 0);
+            uint8_t* registers = &canvas->shown[moduleIndex * 8];
+            if ((canvas->orientations[moduleIndex] != MAX7219_ORIENTATION_NORMAL) && (dirtyRows != 0)) {
+                // A changed pixel can land in any digit register - Recomposite and transform the whole module
+                uint8_t rows[8];
+                for (uint8_t row = 0; row < 8; row++) {
+                    rows[row] = compose_row_private(canvas, moduleColumn, moduleRow, row);
+                }
+                max7219_unpack_rows(max7219_orient(max7219_pack_rows(rows), (max7219_orientation_t) canvas->orientations[moduleIndex]), rows);
+
+                for (uint8_t row = 0; row < 8; row++) {
+                    changedRows |= rows[row] != registers[row] ? 1 << row : 0;
+                }
+                memcpy(registers, rows, sizeof(rows));
+                dirtyRows = 0;
+            }
+
+            for (uint8_t row = 0; dirtyRows != 0; row++, dirtyRows >>= 1) {
+                if ((dirtyRows & 1) == 0) {
+                    continue;
+                }
+
+                uint8_t rowBits = compose_row_private(canvas, moduleColumn, moduleRow, row);
+                if (rowBits != registers[row]) {
+                    registers[row] = rowBits;
+                    changedRows |= 1 << row;
+                }
+            }
+
+            canvas->dirty[moduleIndex] = changedRows;
+            changed |= changedRows != 0;
+        }
+    }
+
+    if (!changed) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = led_driver_max7219_set_changed_digits_timeout(canvas->handle, canvas->config.start_chain_id, MAX7219_MIN_DIGIT, canvas->shown, MODULE_COUNT(canvas) * 8, canvas->dirty, ticksToWait);
+    if (ret == ESP_ERR_TIMEOUT) {
+        // Expected with a bounded wait - The driver is busy and nothing was sent: keep the rows for the next flush
+        canvas->shown_unsent = true;
+        return ret;
+    }
+
+    memset(canvas->dirty, 0, MODULE_COUNT(canvas));
+    canvas->shown_unsent = false;
+    if (ret != ESP_OK) {
+        // Some rows may have been sent - The display content is unknown
+        canvas->shown_valid = false;
+        ESP_LOGE(LedDriverMax7219CanvasLogTag, "Failed to send canvas rows");
+        return ret;
+    }
+
+    canvas->shown_valid = true;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_canvas_try_flush(max7219_canvas_t* canvas) {
+    return led_driver_max7219_canvas_flush_timeout(canvas, 0);
+}
+
+esp_err_t led_driver_max7219_canvas_invalidate(max7219_canvas_t* canvas) {
+    ESP_RETURN_ON_FALSE((canvas != NULL) && (canvas->pixels != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219CanvasLogTag, "'canvas' must be initialized");
+
+    canvas->shown_valid = false;
+    return ESP_OK;
+}
+
+
+
+static int16_t sprite_index_private(const max7219_canvas_t* canvas, const max7219_sprite_t* sprite) {
+    for (uint8_t index = 0; index < canvas->sprite_count; index++) {
+        if (canvas->sprites[index] == sprite) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+static void mark_rect_dirty_private(max7219_canvas_t* canvas, int32_t x, int32_t y, int32_t width, int32_t height) {
+    // Clip to the canvas - 'x1' and 'y1' are exclusive
+    int32_t x0 = x < 0 ? 0 : x;
+    int32_t y0 = y < 0 ? 0 : y;
+    int32_t x1 = x + width > canvas->width ? canvas->width : x + width;
+    int32_t y1 = y + height > canvas->height ? canvas->height : y + height;
+    if ((x0 >= x1) || (y0 >= y1)) {
+        return;
+    }
+
+    for (int32_t moduleRow = y0 / 8; moduleRow <= (y1 - 1) / 8; moduleRow++) {
+        int32_t firstRow = y0 > moduleRow * 8 ? y0 - moduleRow * 8 : 0;
+        int32_t lastRow = y1 < (moduleRow + 1) * 8 ? y1 - 1 - moduleRow * 8 : 7;
+        uint8_t rows = span_mask_private(7 - lastRow, 7 - firstRow);
+        for (int32_t moduleColumn = x0 / 8; moduleColumn <= (x1 - 1) / 8; moduleColumn++) {
+            canvas->dirty[moduleRow * canvas->config.modules_per_row + moduleColumn] |= rows;
+        }
+    }
+}
+
+static void mark_sprite_dirty_private(max7219_canvas_t* canvas, const max7219_sprite_t* sprite) {
+    if (sprite->visible) {
+        mark_rect_dirty_private(canvas, sprite->x, sprite->y, sprite->width, sprite->height);
+    }
+}
+
+static uint8_t span_mask_private(int32_t first, int32_t last) {
+    // Bits for columns 'first' to 'last' of a byte, column 0 in the most significant bit
+    return (uint8_t) ((0xFF >> first) & (0xFF << (7 - last)));
+}
+
+static uint8_t bitmap_row_mask_private(uint8_t width, int32_t offset) {
+    // Bits of a canvas byte over bitmap columns 'offset' to 'offset + 7' which are within the bitmap
+    int32_t first = offset < 0 ? -offset : 0;
+    int32_t last = width - offset < 8 ? width - 1 - offset : 7;
+    return first <= last ? span_mask_private(first, last) : 0;
+}
+
+static uint8_t bitmap_row_bits_private(const uint8_t* bitmapRow, uint8_t width, int32_t offset) {
+    // Bitmap columns 'offset' to 'offset + 7' - Columns outside the bitmap are off
+    uint8_t mask = bitmap_row_mask_private(width, offset);
+    if (mask == 0) {
+        return 0;
+    }
+
+    uint8_t rowBits = 0;
+    if (offset < 0) {
+        // The bitmap starts within this byte
+        rowBits = bitmapRow[0] >> -offset;
+    } else {
+        // The columns may straddle two bitmap bytes
+        int32_t byteIndex = offset / 8;
+        int32_t shift = offset % 8;
+        rowBits = (uint8_t) (bitmapRow[byteIndex] << shift);
+        if ((shift != 0) && ((byteIndex + 1) * 8 < width)) {
+            rowBits |= bitmapRow[byteIndex + 1] >> (8 - shift);
+        }
+    }
+
+    return rowBits & mask;
+}
+
+static uint8_t sprite_row_bits_private(const max7219_sprite_t* sprite, int32_t y, int32_t moduleX) {
+    // Columns of the sprite over the eight canvas columns starting at 'moduleX'
+    if ((y < sprite->y) || (y >= sprite->y + sprite->height)) {
+        return 0;
+    }
+
+    return bitmap_row_bits_private(&sprite->bitmap[(y - sprite->y) * ((sprite->width + 7) / 8)], sprite->width, moduleX - sprite->x);
+}
+
+static void combine_byte_private(max7219_canvas_t* canvas, int32_t y, int32_t byteIndex, uint8_t bits, uint8_t mask, max7219_draw_mode_t mode) {
+    // Combine 'bits' into the pixels under 'mask' - Only a module row whose pixels change is marked
+    uint8_t* pixels = &canvas->pixels[y * canvas->config.modules_per_row + byteIndex];
+    uint8_t value = *pixels;
+    switch (mode) {
+        case MAX7219_DRAW_OR:
+            value |= bits & mask;
+            break;
+        case MAX7219_DRAW_AND:
+            value &= bits | (uint8_t) ~mask;
+            break;
+        case MAX7219_DRAW_XOR:
+            value ^= bits & mask;
+            break;
+        case MAX7219_DRAW_CLEAR:
+            value &= (uint8_t) ~(bits & mask);
+            break;
+    }
+
+    if (value != *pixels) {
+        *pixels = value;
+        canvas->dirty[(y / 8) * canvas->config.modules_per_row + byteIndex] |= 1 << (y % 8);
+    }
+}
+
+static void draw_pixel_private(max7219_canvas_t* canvas, int32_t x, int32_t y, max7219_draw_mode_t mode) {
+    if ((x >= 0) && (y >= 0) && (x < canvas->width) && (y < canvas->height)) {
+        uint8_t bit = 0x80 >> (x % 8);
+        combine_byte_private(canvas, y, x / 8, bit, bit, mode);
+    }
+}
+
+static void draw_span_private(max7219_canvas_t* canvas, int32_t x0, int32_t x1, int32_t y, max7219_draw_mode_t mode) {
+    // Columns 'x0' to 'x1' of row 'y', clipped - Partial bytes at both ends are combined with a mask and whole bytes in between a word at a time
+    x0 = x0 < 0 ? 0 : x0;
+    x1 = x1 >= canvas->width ? canvas->width - 1 : x1;
+    if ((y < 0) || (y >= canvas->height) || (x0 > x1)) {
+        return;
+    }
+
+    int32_t firstByte = x0 / 8;
+    int32_t lastByte = x1 / 8;
+    if (firstByte == lastByte) {
+        uint8_t mask = span_mask_private(x0 % 8, x1 % 8);
+        combine_byte_private(canvas, y, firstByte, mask, mask, mode);
+        return;
+    }
+
+    uint8_t firstMask = span_mask_private(x0 % 8, 7);
+    uint8_t lastMask = span_mask_private(0, x1 % 8);
+    combine_byte_private(canvas, y, firstByte, firstMask, firstMask, mode);
+    fill_bytes_private(canvas, y, firstByte + 1, lastByte - 1, mode);
+    combine_byte_private(canvas, y, lastByte, lastMask, lastMask, mode);
+}
+
+static void fill_bytes_private(max7219_canvas_t* canvas, int32_t y, int32_t firstByte, int32_t lastByte, max7219_draw_mode_t mode) {
+    // Whole bytes 'firstByte' to 'lastByte' of row 'y' - Four modules at a time with a 32 bit word, then the remaining bytes one by one
+    // NOTE: Every byte of a word is fully covered so the word mask is all ones and byte order does not matter. Each module is still
+    //       marked on its own since a module row is the unit the display is updated by
+    uint8_t* row = &canvas->pixels[y * canvas->config.modules_per_row];
+    int32_t byteIndex = firstByte;
+    for (; byteIndex + 3 <= lastByte; byteIndex += 4) {
+        uint32_t word;
+        memcpy(&word, &row[byteIndex], sizeof(word));
+        uint32_t value = mode == MAX7219_DRAW_OR ? UINT32_MAX : mode == MAX7219_DRAW_XOR ? ~word : 0;
+        if (value == word) {
+            continue;
+        }
+
+        memcpy(&row[byteIndex], &value, sizeof(value));
+        uint32_t changedWord = value ^ word;
+        uint8_t changed[sizeof(changedWord)];
+        memcpy(changed, &changedWord, sizeof(changedWord));
+        for (uint8_t index = 0; index < sizeof(changed); index++) {
+            if (changed[index] != 0) {
+                canvas->dirty[(y / 8) * canvas->config.modules_per_row + byteIndex + index] |= 1 << (y % 8);
+            }
+        }
+    }
+
+    for (; byteIndex <= lastByte; byteIndex++) {
+        combine_byte_private(canvas, y, byteIndex, 0xFF, 0xFF, mode);
+    }
+}
+
+static void draw_vertical_private(max7219_canvas_t* canvas, int32_t x, int32_t y0, int32_t y1, max7219_draw_mode_t mode) {
+    // Rows 'y0' to 'y1' of column 'x', clipped
+    y0 = y0 < 0 ? 0 : y0;
+    y1 = y1 >= canvas->height ? canvas->height - 1 : y1;
+    if ((x < 0) || (x >= canvas->width)) {
+        return;
+    }
+
+    uint8_t bit = 0x80 >> (x % 8);
+    for (int32_t y = y0; y <= y1; y++) {
+        combine_byte_private(canvas, y, x / 8, bit, bit, mode);
+    }
+}
+
+static uint8_t compose_row_private(const max7219_canvas_t* canvas, uint8_t moduleColumn, uint8_t moduleRow, uint8_t row) {
+    int32_t y = moduleRow * 8 + row;
+    uint8_t rowBits = canvas->pixels[y * canvas->config.modules_per_row + moduleColumn];
+    for (uint8_t index = 0; index < canvas->sprite_count; index++) {
+        const max7219_sprite_t* sprite = canvas->sprites[index];
+        if (sprite->visible) {
+            rowBits |= sprite_row_bits_private(sprite, y, moduleColumn * 8);
+        }
+    }
+    return rowBits;
+}
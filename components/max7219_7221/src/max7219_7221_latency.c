@@ -0,0 +1,140 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include <esp_attr.h>
+#include <esp_check.h>
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+#include <esp_console.h>
+#endif
+
+#include "max7219_7221.h"
+
+
+static const char* const LatencyApiNames[MAX7219_LATENCY_API_COUNT] = {
+    "configure_decode",
+    "configure_scan_limit",
+    "set_mode",
+    "set_intensity",
+    "set_digits",
+    "flush",
+    "play_script",
+    "send_wire_frames"
+};
+
+static const char* const LatencyStageNames[MAX7219_LATENCY_STAGE_COUNT] = {
+    "mutex_wait",
+    "bus_acquire",
+    "encode",
+    "transmit",
+    "total"
+};
+
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+DRAM_ATTR static const char* LedDriverMax7219LatencyLogTag = "leddriver_max72[19|21]_latency";
+
+// Driver inspected by the console command - Console commands do not carry a context
+static led_driver_max7219_handle_t LatencyConsoleHandle = NULL;
+
+static int latency_console_command(int argc, char** argv);
+#endif
+
+
+
+uint32_t led_driver_max7219_latency_percentile(const max7219_latency_histogram_t* histogram, uint8_t percentile) {
+    if ((histogram == NULL) || (histogram->count == 0)) {
+        return 0;
+    }
+
+    // 1-based rank of the sample at the requested percentile
+    uint64_t rank = ((uint64_t) histogram->count * (percentile > 100 ? 100 : percentile) + 99) / 100;
+    rank = rank == 0 ? 1 : rank;
+
+    uint64_t samples = 0;
+    for (uint8_t bucket = 0; bucket < MAX7219_LATENCY_BUCKET_COUNT - 1; bucket++) {
+        samples += histogram->buckets[bucket];
+        if (samples >= rank) {
+            uint32_t upperBoundUs = bucket == 0 ? 0 : (1UL << bucket) - 1;
+            return upperBoundUs < histogram->max_us ? upperBoundUs : histogram->max_us;
+        }
+    }
+
+    // The last bucket is unbounded
+    return histogram->max_us;
+}
+
+void led_driver_max7219_print_latency_trace(const max7219_latency_trace_t* trace) {
+    if (trace == NULL) {
+        return;
+    }
+
+    printf("%-20s %-12s %10s %10s %10s %10s\n", "api", "stage", "count", "p50_us", "p99_us", "max_us");
+    for (uint8_t api = 0; api < MAX7219_LATENCY_API_COUNT; api++) {
+        // Every stage of an operation has the same number of samples
+        if (trace->histograms[api][MAX7219_LATENCY_STAGE_TOTAL].count == 0) {
+            continue;
+        }
+
+        for (uint8_t stage = 0; stage < MAX7219_LATENCY_STAGE_COUNT; stage++) {
+            const max7219_latency_histogram_t* histogram = &trace->histograms[api][stage];
+            printf("%-20s %-12s %10lu %10lu %10lu %10lu\n", LatencyApiNames[api], LatencyStageNames[stage],
+                    (unsigned long) histogram->count,
+                    (unsigned long) led_driver_max7219_latency_percentile(histogram, 50),
+                    (unsigned long) led_driver_max7219_latency_percentile(histogram, 99),
+                    (unsigned long) histogram->max_us);
+        }
+    }
+}
+
+esp_err_t led_driver_max7219_register_latency_console_command(led_driver_max7219_handle_t handle) {
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+    ESP_RETURN_ON_FALSE(handle != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219LatencyLogTag, "'handle' must not be NULL");
+
+    bool registered = LatencyConsoleHandle != NULL;
+    LatencyConsoleHandle = handle;
+    if (registered) {
+        return ESP_OK;
+    }
+
+    const esp_console_cmd_t command = {
+        .command = "max7219_latency",
+        .help = "Print MAX7219 / MAX7221 driver latency histograms (p50, p99, max) per operation and stage. 'reset' clears histograms after printing",
+        .hint = "[reset]",
+        .func = latency_console_command
+    };
+    esp_err_t err = esp_console_cmd_register(&command);
+    if (err != ESP_OK) {
+        LatencyConsoleHandle = NULL;
+    }
+    return err;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#if CONFIG_MAX_7219_7221_ENABLE_LATENCY_TRACING
+static int latency_console_command(int argc, char** argv) {
+    bool reset = (argc > 1) && (strcmp(argv[1], "reset") == 0);
+
+    // Too large for most console task stacks
+    max7219_latency_trace_t* trace = heap_caps_malloc(sizeof(max7219_latency_trace_t), MALLOC_CAP_DEFAULT);
+    if (trace == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    esp_err_t err = led_driver_max7219_get_latency_trace(LatencyConsoleHandle, trace, reset);
+    if (err == ESP_OK) {
+        led_driver_max7219_print_latency_trace(trace);
+    } else {
+        printf("Could not read latency trace (%s)\n", esp_err_to_name(err));
+    }
+
+    heap_caps_free(trace);
+    return err == ESP_OK ? 0 : 1;
+}
+#endif
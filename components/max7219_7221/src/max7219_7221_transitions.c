@@ -0,0 +1,286 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include <esp_attr.h>
+#include <esp_check.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "max7219_7221_transitions.h"
+
+
+DRAM_ATTR static const char* LedDriverMax7219TransitionsLogTag = "leddriver_max72[19|21]_transitions";
+
+#define DEFAULT_DISSOLVE_TICKS 16
+
+// Maximal length Galois linear feedback shift register taps, indexed by register width - A register of width 'n' visits 1 to 2^n - 1 once each
+static const uint16_t LfsrTaps[15] = { 0, 0, 0x0003, 0x0006, 0x000C, 0x0014, 0x0030, 0x0060, 0x00B8, 0x0110, 0x0240, 0x0500, 0x0829, 0x100D, 0x2015 };
+
+// Segments in build up order - On matrix modules, bit 6 (column 1) first and bit 7 (column 0) last
+static const uint8_t SegmentOrder[8] = {
+    MAX7219_SEGMENT_A, MAX7219_SEGMENT_B, MAX7219_SEGMENT_C, MAX7219_SEGMENT_D, MAX7219_SEGMENT_E, MAX7219_SEGMENT_F, MAX7219_SEGMENT_G, MAX7219_SEGMENT_DP
+};
+
+
+static esp_err_t run_tick_private(max7219_transition_t* transition, TickType_t ticksToWait);
+static void combine_target_private(max7219_transition_t* transition, uint16_t y, uint16_t byteIndex, uint8_t mask);
+static void store_byte_private(max7219_canvas_t* canvas, uint16_t y, uint16_t byteIndex, uint8_t value);
+static void stop_ticks_private(max7219_transition_t* transition);
+static bool ticking_private(max7219_transition_t* transition);
+static void transition_timer_callback(void* arg);
+
+
+
+esp_err_t led_driver_max7219_transition_init(max7219_transition_t* transition, max7219_canvas_t* canvas, const max7219_transition_config_t* config) {
+    ESP_RETURN_ON_FALSE((transition != NULL) && (canvas != NULL) && (canvas->pixels != NULL) && (config != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219TransitionsLogTag, "'transition' and 'config' must not be NULL and 'canvas' must be initialized");
+    ESP_RETURN_ON_FALSE((config->effect >= MAX7219_TRANSITION_WIPE) && (config->effect <= MAX7219_TRANSITION_SEGMENTS), ESP_ERR_INVALID_ARG, LedDriverMax7219TransitionsLogTag, "Invalid effect");
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    ESP_RETURN_ON_FALSE(config->tick_ms == 0, ESP_ERR_NOT_SUPPORTED, LedDriverMax7219TransitionsLogTag, "'tick_ms' is not supported with CONFIG_MAX_7219_7221_SINGLE_OWNER");
+#endif
+
+    memset(transition, 0, sizeof(max7219_transition_t));
+    transition->canvas = canvas;
+    transition->config = *config;
+    transition->done = true;
+    portMUX_INITIALIZE(&transition->lock);
+
+    if (config->tick_ms > 0) {
+        esp_timer_create_args_t timerArgs = {
+            .callback = transition_timer_callback,
+            .arg = transition,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "max7219_transition",
+            .skip_unhandled_events = true
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timerArgs, &transition->timer), LedDriverMax7219TransitionsLogTag, "Failed to create transition timer");
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_transition_start(max7219_transition_t* transition, const uint8_t* target) {
+    ESP_RETURN_ON_FALSE((transition != NULL) && (transition->canvas != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219TransitionsLogTag, "'transition' must be initialized");
+    ESP_RETURN_ON_FALSE(target != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219TransitionsLogTag, "'target' must not be NULL");
+
+    if (transition->timer != NULL) {
+        stop_ticks_private(transition);
+    }
+
+    max7219_canvas_t* canvas = transition->canvas;
+    transition->target = target;
+    transition->tick = 0;
+    switch (transition->config.effect) {
+        case MAX7219_TRANSITION_WIPE:
+        case MAX7219_TRANSITION_SLIDE:
+            transition->tick_count = canvas->width;
+            break;
+
+        case MAX7219_TRANSITION_DISSOLVE: {
+            // Narrowest register covering every pixel - Pixel 'lfsr - 1' switches when the register holds 'lfsr'
+            uint32_t pixelCount = (uint32_t) canvas->width * canvas->height;
+            uint8_t lfsrWidth = 2;
+            while (((1UL << lfsrWidth) - 1) < pixelCount) {
+                lfsrWidth++;
+            }
+            transition->tick_count = transition->config.dissolve_ticks > 0 ? transition->config.dissolve_ticks : DEFAULT_DISSOLVE_TICKS;
+            transition->lfsr = 1;
+            transition->lfsr_taps = LfsrTaps[lfsrWidth];
+            transition->pixels_per_tick = (pixelCount + transition->tick_count - 1) / transition->tick_count;
+        }
+        break;
+
+        case MAX7219_TRANSITION_SEGMENTS:
+            transition->tick_count = sizeof(SegmentOrder);
+            break;
+    }
+    transition->done = false;
+    transition->flush_pending = false;
+
+    if (transition->timer != NULL) {
+        portENTER_CRITICAL(&transition->lock);
+        transition->stopping = false;
+        portEXIT_CRITICAL(&transition->lock);
+        ESP_RETURN_ON_ERROR(esp_timer_start_periodic(transition->timer, (uint64_t) transition->config.tick_ms * 1000), LedDriverMax7219TransitionsLogTag, "Failed to start transition timer");
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_transition_step(max7219_transition_t* transition, bool* done) {
+    ESP_RETURN_ON_FALSE((transition != NULL) && (transition->canvas != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219TransitionsLogTag, "'transition' must be initialized");
+    ESP_RETURN_ON_FALSE(transition->timer == NULL, ESP_ERR_INVALID_STATE, LedDriverMax7219TransitionsLogTag, "The transition is driven by a timer");
+
+    esp_err_t ret = transition->done ? ESP_OK : run_tick_private(transition, portMAX_DELAY);
+    if (done != NULL) {
+        *done = transition->done;
+    }
+    return ret;
+}
+
+bool led_driver_max7219_transition_is_done(const max7219_transition_t* transition) {
+    return (transition == NULL) || (transition->done && !transition->flush_pending);
+}
+
+esp_err_t led_driver_max7219_transition_deinit(max7219_transition_t* transition) {
+    ESP_RETURN_ON_FALSE(transition != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219TransitionsLogTag, "'transition' must not be NULL");
+
+    if (transition->timer != NULL) {
+        stop_ticks_private(transition);
+        esp_timer_delete(transition->timer);
+    }
+    memset(transition, 0, sizeof(max7219_transition_t));
+    transition->done = true;
+    return ESP_OK;
+}
+
+
+
+static esp_err_t run_tick_private(max7219_transition_t* transition, TickType_t ticksToWait) {
+    max7219_canvas_t* canvas = transition->canvas;
+    const uint16_t stride = canvas->config.modules_per_row;
+
+    switch (transition->config.effect) {
+        case MAX7219_TRANSITION_WIPE: {
+            // Column 'tick' takes its new pixels
+            uint16_t column = transition->tick;
+            for (uint16_t y = 0; y < canvas->height; y++) {
+                combine_target_private(transition, y, column / 8, 0x80 >> (column % 8));
+            }
+        }
+        break;
+
+        case MAX7219_TRANSITION_SLIDE: {
+            // Shift every row one column left and bring in column 'tick' of the new frame on the right
+            uint16_t column = transition->tick;
+            for (uint16_t y = 0; y < canvas->height; y++) {
+                const uint8_t* row = &canvas->pixels[y * stride];
+                for (uint16_t byteIndex = 0; byteIndex < stride; byteIndex++) {
+                    uint8_t next = byteIndex + 1 < stride ? row[byteIndex + 1] >> 7 : (transition->target[y * stride + column / 8] >> (7 - column % 8)) & 1;
+                    store_byte_private(canvas, y, byteIndex, (uint8_t) (row[byteIndex] << 1) | next);
+                }
+            }
+        }
+        break;
+
+        case MAX7219_TRANSITION_DISSOLVE: {
+            // Switch the next pixels in register order, skipping values past the last pixel
+            uint32_t pixelCount = (uint32_t) canvas->width * canvas->height;
+            uint16_t switched = 0;
+            while (switched < transition->pixels_per_tick) {
+                uint32_t pixel = transition->lfsr - 1;
+                uint16_t lsb = transition->lfsr & 1;
+                transition->lfsr = (transition->lfsr >> 1) ^ (lsb != 0 ? transition->lfsr_taps : 0);
+                if (pixel < pixelCount) {
+                    uint16_t x = pixel % canvas->width;
+                    combine_target_private(transition, pixel / canvas->width, x / 8, 0x80 >> (x % 8));
+                    switched++;
+                }
+                if (transition->lfsr == 1) {
+                    // Every pixel was visited
+                    break;
+                }
+            }
+        }
+        break;
+
+        case MAX7219_TRANSITION_SEGMENTS: {
+            // Segment 'tick' of every digit takes its new state
+            uint8_t segment = SegmentOrder[transition->tick];
+            for (uint16_t y = 0; y < canvas->height; y++) {
+                for (uint16_t byteIndex = 0; byteIndex < stride; byteIndex++) {
+                    combine_target_private(transition, y, byteIndex, segment);
+                }
+            }
+        }
+        break;
+    }
+
+    // The last tick leaves the canvas exactly on the new frame
+    if (++transition->tick >= transition->tick_count) {
+        for (uint16_t y = 0; y < canvas->height; y++) {
+            for (uint16_t byteIndex = 0; byteIndex < stride; byteIndex++) {
+                store_byte_private(canvas, y, byteIndex, transition->target[y * stride + byteIndex]);
+            }
+        }
+        transition->done = true;
+    }
+
+    return led_driver_max7219_canvas_flush_timeout(canvas, ticksToWait);
+}
+
+static void combine_target_private(max7219_transition_t* transition, uint16_t y, uint16_t byteIndex, uint8_t mask) {
+    uint16_t offset = y * transition->canvas->config.modules_per_row + byteIndex;
+    uint8_t value = (transition->canvas->pixels[offset] & (uint8_t) ~mask) | (transition->target[offset] & mask);
+    store_byte_private(transition->canvas, y, byteIndex, value);
+}
+
+static void store_byte_private(max7219_canvas_t* canvas, uint16_t y, uint16_t byteIndex, uint8_t value) {
+    // Only a module row whose pixels change is marked
+    uint8_t* pixels = &canvas->pixels[y * canvas->config.modules_per_row + byteIndex];
+    if (*pixels != value) {
+        *pixels = value;
+        canvas->dirty[(y / 8) * canvas->config.modules_per_row + byteIndex] |= 1 << (y % 8);
+    }
+}
+
+static void stop_ticks_private(max7219_transition_t* transition) {
+    // Once 'stopping' is set, ticks return right away - Wait for a tick already running before touching the transition
+    portENTER_CRITICAL(&transition->lock);
+    transition->stopping = true;
+    portEXIT_CRITICAL(&transition->lock);
+    while (ticking_private(transition)) {
+        vTaskDelay(1);
+    }
+    esp_timer_stop(transition->timer);
+}
+
+static bool ticking_private(max7219_transition_t* transition) {
+    portENTER_CRITICAL(&transition->lock);
+    bool ticking = transition->ticking;
+    portEXIT_CRITICAL(&transition->lock);
+    return ticking;
+}
+
+static void transition_timer_callback(void* arg) {
+    max7219_transition_t* transition = (max7219_transition_t*) arg;
+
+    portENTER_CRITICAL(&transition->lock);
+    bool stopping = transition->stopping;
+    transition->ticking = !stopping;
+    portEXIT_CRITICAL(&transition->lock);
+    if (stopping) {
+        return;
+    }
+
+    // Do not block the timer task on a busy driver - The pixels of a tick which could not be sent go out with the next tick
+    bool pending = !transition->done || transition->flush_pending;
+    esp_err_t err = ESP_OK;
+    if (!transition->done) {
+        err = run_tick_private(transition, 0);
+    } else if (transition->flush_pending) {
+        err = led_driver_max7219_canvas_try_flush(transition->canvas);
+    }
+    transition->flush_pending = transition->done && (err == ESP_ERR_TIMEOUT);
+    if ((err != ESP_OK) && (err != ESP_ERR_TIMEOUT)) {
+        ESP_LOGW(LedDriverMax7219TransitionsLogTag, "Failed to send transition tick (%d)", err);
+    }
+
+    bool finished = transition->done && !transition->flush_pending;
+    if (finished) {
+        esp_timer_stop(transition->timer);
+    }
+    max7219_transition_done_t onDone = pending && finished ? transition->config.on_done : NULL;
+    void* onDoneArg = transition->config.on_done_arg;
+
+    portENTER_CRITICAL(&transition->lock);
+    transition->ticking = false;
+    portEXIT_CRITICAL(&transition->lock);
+
+    // Called once the tick is over so 'on_done' can start the transition again
+    if (onDone != NULL) {
+        onDone(transition, onDoneArg);
+    }
+}
@@ -0,0 +1,533 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+
+#include <string.h>
+#include <sys/time.h>
+
+#include <esp_attr.h>
+#include <esp_check.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "max7219_7221_widgets.h"
+
+
+DRAM_ATTR static const char* LedDriverMax7219WidgetsLogTag = "leddriver_max72[19|21]_widgets";
+
+// Decimal digits drawn with segments, for digits in no decode mode
+static const uint8_t DirectAddressingDigits[10] = {
+    MAX7219_DIRECT_ADDRESSING_0, MAX7219_DIRECT_ADDRESSING_1, MAX7219_DIRECT_ADDRESSING_2, MAX7219_DIRECT_ADDRESSING_3, MAX7219_DIRECT_ADDRESSING_4,
+    MAX7219_DIRECT_ADDRESSING_5, MAX7219_DIRECT_ADDRESSING_6, MAX7219_DIRECT_ADDRESSING_7, MAX7219_DIRECT_ADDRESSING_8, MAX7219_DIRECT_ADDRESSING_9
+};
+
+
+// Bar graph segments for digits in no decode mode - The segments on the side of the digit closest to where bars start light first
+#define BAR_FIRST_HALF_SEGMENTS (MAX7219_SEGMENT_B | MAX7219_SEGMENT_C)
+#define BAR_SECOND_HALF_SEGMENTS (MAX7219_SEGMENT_F | MAX7219_SEGMENT_E)
+
+// Sparkline segments for digits in no decode mode, from the lowest to the highest step
+static const uint8_t SparklineSegments[3] = { MAX7219_SEGMENT_D, MAX7219_SEGMENT_G, MAX7219_SEGMENT_A };
+
+
+// Timer driven clocks update on every second, or every half second with a blinking separator
+#define CLOCK_SECOND_US 1000000
+#define CLOCK_HALF_SECOND_US 500000
+
+// A timer driven clock never waits for the driver mutex on the timer task - It tries again after this delay
+#define CLOCK_RETRY_US 10000
+
+
+static esp_err_t send_changed_codes_private(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t codes[], uint8_t shown[], uint8_t count, bool* shownValid, TickType_t ticksToWait);
+
+static void binary_to_bcd_private(uint32_t value, uint8_t bcd[MAX7219_COUNTER_MAX_DIGITS]);
+static esp_err_t show_counter_private(max7219_counter_t* counter);
+
+static uint32_t smooth_level_private(uint32_t levelQ8, uint32_t sample, uint8_t attackShift, uint8_t decayShift);
+static esp_err_t show_bargraph_private(max7219_bargraph_t* bargraph);
+static esp_err_t show_sparkline_private(max7219_sparkline_t* sparkline);
+
+static esp_err_t show_clock_private(max7219_clock_t* clockWidget, const struct tm* localTime, bool separatorLit, TickType_t ticksToWait);
+static bool clock_updating_private(max7219_clock_t* clockWidget);
+static void clock_timer_callback(void* arg);
+
+
+
+static esp_err_t send_changed_codes_private(led_driver_max7219_handle_t handle, uint8_t startChainId, uint8_t startDigitId, const uint8_t codes[], uint8_t shown[], uint8_t count, bool* shownValid, TickType_t ticksToWait) {
+    // Flag codes which differ from the display, or all codes if the display content is unknown
+    uint8_t changedDigits[(MAX7219_WIDGET_MAX_DIGITS + 7) / 8] = { 0 };
+    bool changed = false;
+    for (uint8_t index = 0; index < count; index++) {
+        if (!*shownValid || (codes[index] != shown[index])) {
+            changedDigits[index / 8] |= 1 << (index % 8);
+            changed = true;
+        }
+    }
+
+    if (!changed) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = led_driver_max7219_set_changed_digits_timeout(handle, startChainId, startDigitId, codes, count, changedDigits, ticksToWait);
+    if (err == ESP_ERR_TIMEOUT) {
+        // Expected with a bounded wait - The driver is busy and nothing was sent so the display still shows 'shown'
+        return err;
+    }
+    if (err != ESP_OK) {
+        // Some digits may have been sent - The display content is unknown
+        *shownValid = false;
+        ESP_LOGE(LedDriverMax7219WidgetsLogTag, "Failed to send widget digits");
+        return err;
+    }
+
+    memcpy(shown, codes, count);
+    *shownValid = true;
+    return ESP_OK;
+}
+
+
+
+esp_err_t led_driver_max7219_counter_init(max7219_counter_t* counter, led_driver_max7219_handle_t handle, const max7219_counter_config_t* config) {
+    ESP_RETURN_ON_FALSE((counter != NULL) && (handle != NULL) && (config != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'counter', 'handle' and 'config' must not be NULL");
+    ESP_RETURN_ON_FALSE(config->start_chain_id >= 1, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_chain_id' must be >= 1");
+    ESP_RETURN_ON_FALSE((config->start_digit_id >= MAX7219_MIN_DIGIT) && (config->start_digit_id <= MAX7219_MAX_DIGIT), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_digit_id' must be between 1 and 8");
+    ESP_RETURN_ON_FALSE((config->digit_count >= 1) && (config->digit_count <= MAX7219_COUNTER_MAX_DIGITS), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'digit_count' must be between 1 and %d", MAX7219_COUNTER_MAX_DIGITS);
+
+    memset(counter, 0, sizeof(max7219_counter_t));
+    counter->handle = handle;
+    counter->config = *config;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_counter_set(max7219_counter_t* counter, uint32_t value) {
+    ESP_RETURN_ON_FALSE((counter != NULL) && (counter->handle != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'counter' must be initialized");
+
+    counter->value = value;
+    binary_to_bcd_private(value, counter->bcd);
+    return show_counter_private(counter);
+}
+
+esp_err_t led_driver_max7219_counter_increment(max7219_counter_t* counter) {
+    ESP_RETURN_ON_FALSE((counter != NULL) && (counter->handle != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'counter' must be initialized");
+
+    // UINT32_MAX + 1 wraps to 0 - The decimal digits would otherwise read 4294967296
+    if (counter->value == UINT32_MAX) {
+        return led_driver_max7219_counter_set(counter, 0);
+    }
+
+    counter->value++;
+    uint8_t digitIndex = 0;
+    while (counter->bcd[digitIndex] == 9) {
+        counter->bcd[digitIndex++] = 0;
+    }
+    counter->bcd[digitIndex]++;
+    return show_counter_private(counter);
+}
+
+esp_err_t led_driver_max7219_counter_invalidate(max7219_counter_t* counter) {
+    ESP_RETURN_ON_FALSE(counter != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'counter' must not be NULL");
+
+    counter->shown_valid = false;
+    return ESP_OK;
+}
+
+static void binary_to_bcd_private(uint32_t value, uint8_t bcd[MAX7219_COUNTER_MAX_DIGITS]) {
+    // Double dabble - Shift 'value' into a packed BCD accumulator one bit at a time. Before each shift, add 3 to every BCD digit >= 5 so it carries into the next digit once doubled
+    // NOTE: A digit d <= 9 is >= 5 exactly when d + 3 has bit 3 set, so all ten digits are adjusted at once without carries between digits
+    uint64_t packed = 0;
+    uint8_t bitCount = 0;
+    if (value != 0) {
+        // Skip leading zero bits, they leave the accumulator at 0
+        bitCount = 32 - __builtin_clz(value);
+        value <<= __builtin_clz(value);
+    }
+    for (uint8_t bit = 0; bit < bitCount; bit++) {
+        uint64_t adjust = (packed + 0x3333333333ULL) & 0x8888888888ULL;
+        packed += (adjust >> 2) | (adjust >> 3);
+        packed = (packed << 1) | (value >> 31);
+        value <<= 1;
+    }
+
+    for (uint8_t digitIndex = 0; digitIndex < MAX7219_COUNTER_MAX_DIGITS; digitIndex++) {
+        bcd[digitIndex] = (packed >> (4 * digitIndex)) & 0x0F;
+    }
+}
+
+static esp_err_t show_counter_private(max7219_counter_t* counter) {
+    const max7219_counter_config_t* config = &counter->config;
+
+    // Digits above the most significant non-zero digit are leading zeros - The least significant digit is always shown
+    uint8_t significantDigits = 1;
+    if (!config->leading_zeros) {
+        for (uint8_t digitIndex = config->digit_count - 1; digitIndex > 0; digitIndex--) {
+            if (counter->bcd[digitIndex] != 0) {
+                significantDigits = digitIndex + 1;
+                break;
+            }
+        }
+    } else {
+        significantDigits = config->digit_count;
+    }
+
+    uint8_t codes[MAX7219_COUNTER_MAX_DIGITS];
+    for (uint8_t digitIndex = 0; digitIndex < config->digit_count; digitIndex++) {
+        uint8_t digit = counter->bcd[digitIndex];
+        if (digitIndex < significantDigits) {
+            codes[digitIndex] = config->code_b ? digit : DirectAddressingDigits[digit];
+        } else {
+            codes[digitIndex] = config->code_b ? MAX7219_CODE_B_BLANK : MAX7219_DIRECT_ADDRESSING_BLANK;
+        }
+    }
+
+    return send_changed_codes_private(counter->handle, config->start_chain_id, config->start_digit_id, codes, counter->shown, config->digit_count, &counter->shown_valid, portMAX_DELAY);
+}
+
+
+
+esp_err_t led_driver_max7219_bargraph_init(max7219_bargraph_t* bargraph, led_driver_max7219_handle_t handle, const max7219_bargraph_config_t* config) {
+    ESP_RETURN_ON_FALSE((bargraph != NULL) && (handle != NULL) && (config != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'bargraph', 'handle' and 'config' must not be NULL");
+    ESP_RETURN_ON_FALSE(config->start_chain_id >= 1, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_chain_id' must be >= 1");
+    ESP_RETURN_ON_FALSE((config->start_digit_id >= MAX7219_MIN_DIGIT) && (config->start_digit_id <= MAX7219_MAX_DIGIT), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_digit_id' must be between 1 and 8");
+    ESP_RETURN_ON_FALSE((config->digit_count >= 1) && (config->digit_count <= MAX7219_WIDGET_MAX_DIGITS), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'digit_count' must be between 1 and %d", MAX7219_WIDGET_MAX_DIGITS);
+    ESP_RETURN_ON_FALSE((config->style == MAX7219_WIDGET_STYLE_SEGMENTS) || (config->style == MAX7219_WIDGET_STYLE_COLUMNS), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "Invalid 'style'");
+    ESP_RETURN_ON_FALSE(config->full_scale > 0, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'full_scale' must not be 0");
+    ESP_RETURN_ON_FALSE((config->attack_shift <= 15) && (config->decay_shift <= 15), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'attack_shift' and 'decay_shift' must be <= 15");
+
+    memset(bargraph, 0, sizeof(max7219_bargraph_t));
+    bargraph->handle = handle;
+    bargraph->config = *config;
+    bargraph->resolution = config->style == MAX7219_WIDGET_STYLE_SEGMENTS ? 2 * config->digit_count : MAX7219_MAX_DIGIT;
+
+    // Rounded up so a full scale sample lights the whole bar - This is the only division, samples are scaled with a multiply and a shift
+    bargraph->scale_q16 = (((uint32_t) bargraph->resolution << 16) + config->full_scale - 1) / config->full_scale;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_bargraph_update(max7219_bargraph_t* bargraph, const uint16_t samples[]) {
+    ESP_RETURN_ON_FALSE((bargraph != NULL) && (bargraph->handle != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'bargraph' must be initialized");
+    ESP_RETURN_ON_FALSE(samples != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'samples' must not be NULL");
+    const max7219_bargraph_config_t* config = &bargraph->config;
+
+    uint8_t barCount = config->style == MAX7219_WIDGET_STYLE_SEGMENTS ? 1 : config->digit_count;
+    for (uint8_t barIndex = 0; barIndex < barCount; barIndex++) {
+        uint32_t sample = samples[barIndex] < config->full_scale ? samples[barIndex] : config->full_scale;
+        bargraph->levels_q8[barIndex] = smooth_level_private(bargraph->levels_q8[barIndex], sample, config->attack_shift, config->decay_shift);
+
+        if (config->peak_hold_updates > 0) {
+            // Peaks follow the raw sample so short transients stay visible while the bar is smoothed
+            uint8_t sampleSteps = (sample * bargraph->scale_q16) >> 16;
+            sampleSteps = sampleSteps < bargraph->resolution ? sampleSteps : bargraph->resolution;
+            if (sampleSteps >= bargraph->peaks[barIndex]) {
+                bargraph->peaks[barIndex] = sampleSteps;
+                bargraph->peak_holds[barIndex] = config->peak_hold_updates;
+            } else if (bargraph->peak_holds[barIndex] > 0) {
+                bargraph->peak_holds[barIndex]--;
+            } else {
+                bargraph->peaks[barIndex]--;
+            }
+        }
+    }
+
+    return show_bargraph_private(bargraph);
+}
+
+esp_err_t led_driver_max7219_bargraph_invalidate(max7219_bargraph_t* bargraph) {
+    ESP_RETURN_ON_FALSE(bargraph != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'bargraph' must not be NULL");
+
+    bargraph->shown_valid = false;
+    return ESP_OK;
+}
+
+static uint32_t smooth_level_private(uint32_t levelQ8, uint32_t sample, uint8_t attackShift, uint8_t decayShift) {
+    // Move 1/2^shift of the way to the sample - Always move at least 1/256 of a sample unit so the level settles on the sample
+    uint32_t targetQ8 = sample << 8;
+    if (targetQ8 > levelQ8) {
+        uint32_t step = (targetQ8 - levelQ8) >> attackShift;
+        return levelQ8 + (step > 0 ? step : 1);
+    } else if (targetQ8 < levelQ8) {
+        uint32_t step = (levelQ8 - targetQ8) >> decayShift;
+        return levelQ8 - (step > 0 ? step : 1);
+    }
+    return levelQ8;
+}
+
+static esp_err_t show_bargraph_private(max7219_bargraph_t* bargraph) {
+    const max7219_bargraph_config_t* config = &bargraph->config;
+    uint8_t codes[MAX7219_WIDGET_MAX_DIGITS];
+
+    if (config->style == MAX7219_WIDGET_STYLE_SEGMENTS) {
+        // One bar across all digits, two steps per digit
+        uint32_t steps = ((bargraph->levels_q8[0] >> 8) * bargraph->scale_q16) >> 16;
+        steps = steps < bargraph->resolution ? steps : bargraph->resolution;
+        uint8_t peak = config->peak_hold_updates > 0 ? bargraph->peaks[0] : 0;
+        for (uint8_t position = 0; position < config->digit_count; position++) {
+            uint8_t code = 0;
+            uint32_t firstStep = 2 * position + 1;
+            if ((steps >= firstStep) || (peak == firstStep)) {
+                code |= config->reverse ? BAR_SECOND_HALF_SEGMENTS : BAR_FIRST_HALF_SEGMENTS;
+            }
+            if ((steps >= firstStep + 1) || (peak == firstStep + 1)) {
+                code |= config->reverse ? BAR_FIRST_HALF_SEGMENTS : BAR_SECOND_HALF_SEGMENTS;
+            }
+            codes[config->reverse ? config->digit_count - 1 - position : position] = code;
+        }
+    } else {
+        // One bar per digit, one LED per step
+        for (uint8_t barIndex = 0; barIndex < config->digit_count; barIndex++) {
+            uint32_t steps = ((bargraph->levels_q8[barIndex] >> 8) * bargraph->scale_q16) >> 16;
+            steps = steps < MAX7219_MAX_DIGIT ? steps : MAX7219_MAX_DIGIT;
+            uint8_t peak = config->peak_hold_updates > 0 ? bargraph->peaks[barIndex] : 0;
+            if (config->reverse) {
+                codes[barIndex] = (uint8_t) (0xFF00 >> steps) | (peak > 0 ? 0x80 >> (peak - 1) : 0);
+            } else {
+                codes[barIndex] = ((1 << steps) - 1) | (peak > 0 ? 1 << (peak - 1) : 0);
+            }
+        }
+    }
+
+    return send_changed_codes_private(bargraph->handle, config->start_chain_id, config->start_digit_id, codes, bargraph->shown, config->digit_count, &bargraph->shown_valid, portMAX_DELAY);
+}
+
+
+
+esp_err_t led_driver_max7219_sparkline_init(max7219_sparkline_t* sparkline, led_driver_max7219_handle_t handle, const max7219_sparkline_config_t* config) {
+    ESP_RETURN_ON_FALSE((sparkline != NULL) && (handle != NULL) && (config != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'sparkline', 'handle' and 'config' must not be NULL");
+    ESP_RETURN_ON_FALSE(config->start_chain_id >= 1, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_chain_id' must be >= 1");
+    ESP_RETURN_ON_FALSE((config->start_digit_id >= MAX7219_MIN_DIGIT) && (config->start_digit_id <= MAX7219_MAX_DIGIT), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_digit_id' must be between 1 and 8");
+    ESP_RETURN_ON_FALSE((config->digit_count >= 1) && (config->digit_count <= MAX7219_WIDGET_MAX_DIGITS), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'digit_count' must be between 1 and %d", MAX7219_WIDGET_MAX_DIGITS);
+    ESP_RETURN_ON_FALSE((config->style == MAX7219_WIDGET_STYLE_SEGMENTS) || (config->style == MAX7219_WIDGET_STYLE_COLUMNS), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "Invalid 'style'");
+    ESP_RETURN_ON_FALSE(config->full_scale > 0, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'full_scale' must not be 0");
+
+    memset(sparkline, 0, sizeof(max7219_sparkline_t));
+    sparkline->handle = handle;
+    sparkline->config = *config;
+    sparkline->resolution = config->style == MAX7219_WIDGET_STYLE_SEGMENTS ? sizeof(SparklineSegments) : MAX7219_MAX_DIGIT;
+
+    // Split the sample range in 'resolution' equal steps - Rounded up so samples on a step boundary land on the upper step
+    sparkline->scale_q16 = (((uint32_t) sparkline->resolution << 16) + config->full_scale - 1) / config->full_scale;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_sparkline_push(max7219_sparkline_t* sparkline, const uint16_t samples[], uint16_t samplesCount) {
+    ESP_RETURN_ON_FALSE((sparkline != NULL) && (sparkline->handle != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'sparkline' must be initialized");
+    ESP_RETURN_ON_FALSE((samples != NULL) || (samplesCount == 0), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'samples' must not be NULL");
+    const max7219_sparkline_config_t* config = &sparkline->config;
+
+    // Only the last 'digit_count' samples can be seen
+    uint16_t firstSample = samplesCount > config->digit_count ? samplesCount - config->digit_count : 0;
+    for (uint16_t sampleIndex = firstSample; sampleIndex < samplesCount; sampleIndex++) {
+        uint32_t sample = samples[sampleIndex] < config->full_scale ? samples[sampleIndex] : config->full_scale;
+        uint32_t steps = (sample * sparkline->scale_q16) >> 16;
+
+        sparkline->head = sparkline->head + 1 < config->digit_count ? sparkline->head + 1 : 0;
+        sparkline->history[sparkline->head] = steps < sparkline->resolution ? steps : sparkline->resolution - 1U;
+        sparkline->count = sparkline->count < config->digit_count ? sparkline->count + 1 : config->digit_count;
+    }
+
+    return show_sparkline_private(sparkline);
+}
+
+esp_err_t led_driver_max7219_sparkline_invalidate(max7219_sparkline_t* sparkline) {
+    ESP_RETURN_ON_FALSE(sparkline != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'sparkline' must not be NULL");
+
+    sparkline->shown_valid = false;
+    return ESP_OK;
+}
+
+static esp_err_t show_sparkline_private(max7219_sparkline_t* sparkline) {
+    const max7219_sparkline_config_t* config = &sparkline->config;
+    uint8_t codes[MAX7219_WIDGET_MAX_DIGITS];
+
+    // Walk the history from the newest sample - Digits without a sample yet are blank
+    uint8_t historyIndex = sparkline->head;
+    for (uint8_t age = 0; age < config->digit_count; age++) {
+        uint8_t code = 0;
+        if (age < sparkline->count) {
+            uint8_t steps = sparkline->history[historyIndex];
+            if (config->style == MAX7219_WIDGET_STYLE_SEGMENTS) {
+                code = SparklineSegments[steps];
+            } else {
+                code = config->filled ? (2 << steps) - 1 : 1 << steps;
+            }
+            historyIndex = historyIndex > 0 ? historyIndex - 1 : config->digit_count - 1;
+        }
+        codes[config->reverse ? config->digit_count - 1 - age : age] = code;
+    }
+
+    return send_changed_codes_private(sparkline->handle, config->start_chain_id, config->start_digit_id, codes, sparkline->shown, config->digit_count, &sparkline->shown_valid, portMAX_DELAY);
+}
+
+
+
+esp_err_t led_driver_max7219_clock_init(max7219_clock_t* clockWidget, led_driver_max7219_handle_t handle, const max7219_clock_config_t* config) {
+    ESP_RETURN_ON_FALSE((clockWidget != NULL) && (handle != NULL) && (config != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'clockWidget', 'handle' and 'config' must not be NULL");
+    ESP_RETURN_ON_FALSE(config->start_chain_id >= 1, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_chain_id' must be >= 1");
+    ESP_RETURN_ON_FALSE((config->start_digit_id >= MAX7219_MIN_DIGIT) && (config->start_digit_id <= MAX7219_MAX_DIGIT), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'start_digit_id' must be between 1 and 8");
+    ESP_RETURN_ON_FALSE((config->layout >= MAX7219_CLOCK_LAYOUT_HH_MM) && (config->layout <= MAX7219_CLOCK_LAYOUT_MM_DD_YY), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "Invalid 'layout'");
+    ESP_RETURN_ON_FALSE((config->separator >= MAX7219_CLOCK_SEPARATOR_NONE) && (config->separator <= MAX7219_CLOCK_SEPARATOR_BLINK), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "Invalid 'separator'");
+#if CONFIG_MAX_7219_7221_SINGLE_OWNER
+    ESP_RETURN_ON_FALSE(!config->timer_driven, ESP_ERR_NOT_SUPPORTED, LedDriverMax7219WidgetsLogTag, "'timer_driven' is not supported with CONFIG_MAX_7219_7221_SINGLE_OWNER");
+#endif
+
+    memset(clockWidget, 0, sizeof(max7219_clock_t));
+    clockWidget->handle = handle;
+    clockWidget->config = *config;
+    clockWidget->digit_count = config->layout == MAX7219_CLOCK_LAYOUT_HH_MM ? 4 : 6;
+    portMUX_INITIALIZE(&clockWidget->lock);
+
+    if (config->timer_driven) {
+        esp_timer_create_args_t timerArgs = {
+            .callback = clock_timer_callback,
+            .arg = clockWidget,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "max7219_clock",
+            .skip_unhandled_events = true
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timerArgs, &clockWidget->timer), LedDriverMax7219WidgetsLogTag, "Failed to create clock timer");
+
+        // The first update runs right away and arms the timer for the next second
+        esp_err_t err = esp_timer_start_once(clockWidget->timer, 0);
+        if (err != ESP_OK) {
+            esp_timer_delete(clockWidget->timer);
+            clockWidget->timer = NULL;
+            ESP_RETURN_ON_ERROR(err, LedDriverMax7219WidgetsLogTag, "Failed to start clock timer");
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_clock_show(max7219_clock_t* clockWidget, const struct tm* localTime, bool separatorLit) {
+    ESP_RETURN_ON_FALSE((clockWidget != NULL) && (clockWidget->handle != NULL), ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'clockWidget' must be initialized");
+    ESP_RETURN_ON_FALSE(localTime != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'localTime' must not be NULL");
+
+    return show_clock_private(clockWidget, localTime, separatorLit, portMAX_DELAY);
+}
+
+esp_err_t led_driver_max7219_clock_invalidate(max7219_clock_t* clockWidget) {
+    ESP_RETURN_ON_FALSE(clockWidget != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'clockWidget' must not be NULL");
+
+    clockWidget->shown_valid = false;
+    return ESP_OK;
+}
+
+esp_err_t led_driver_max7219_clock_deinit(max7219_clock_t* clockWidget) {
+    ESP_RETURN_ON_FALSE(clockWidget != NULL, ESP_ERR_INVALID_ARG, LedDriverMax7219WidgetsLogTag, "'clockWidget' must not be NULL");
+
+    if (clockWidget->timer != NULL) {
+        // Once 'stopping' is set, updates return right away and only an update already running can arm the timer again
+        portENTER_CRITICAL(&clockWidget->lock);
+        clockWidget->stopping = true;
+        portEXIT_CRITICAL(&clockWidget->lock);
+        while (clock_updating_private(clockWidget)) {
+            vTaskDelay(1);
+        }
+
+        esp_timer_stop(clockWidget->timer);
+        esp_timer_delete(clockWidget->timer);
+    }
+    memset(clockWidget, 0, sizeof(max7219_clock_t));
+    return ESP_OK;
+}
+
+static esp_err_t show_clock_private(max7219_clock_t* clockWidget, const struct tm* localTime, bool separatorLit, TickType_t ticksToWait) {
+    const max7219_clock_config_t* config = &clockWidget->config;
+
+    // Two digit fields, least significant first
+    int hour = localTime->tm_hour;
+    if (config->hour_12) {
+        hour = hour % 12 != 0 ? hour % 12 : 12;
+    }
+    int fields[MAX7219_CLOCK_MAX_DIGITS / 2];
+    switch (config->layout) {
+        case MAX7219_CLOCK_LAYOUT_HH_MM:
+            fields[0] = localTime->tm_min;
+            fields[1] = hour;
+            break;
+        case MAX7219_CLOCK_LAYOUT_HH_MM_SS:
+            fields[0] = localTime->tm_sec;
+            fields[1] = localTime->tm_min;
+            fields[2] = hour;
+            break;
+        case MAX7219_CLOCK_LAYOUT_DD_MM_YY:
+            fields[0] = localTime->tm_year;
+            fields[1] = localTime->tm_mon + 1;
+            fields[2] = localTime->tm_mday;
+            break;
+        case MAX7219_CLOCK_LAYOUT_MM_DD_YY:
+            fields[0] = localTime->tm_year;
+            fields[1] = localTime->tm_mday;
+            fields[2] = localTime->tm_mon + 1;
+            break;
+    }
+
+    uint8_t fieldCount = clockWidget->digit_count / 2;
+    uint8_t codes[MAX7219_CLOCK_MAX_DIGITS];
+    for (uint8_t fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++) {
+        // Years count from 1900 - 2024 is 124 and shows as 24
+        uint8_t value = (uint8_t) ((fields[fieldIndex] >= 0 ? fields[fieldIndex] : 0) % 100);
+        uint8_t ones = value % 10;
+        uint8_t tens = value / 10;
+        codes[2 * fieldIndex] = config->code_b ? ones : DirectAddressingDigits[ones];
+        codes[2 * fieldIndex + 1] = config->code_b ? tens : DirectAddressingDigits[tens];
+
+        // The separator on the left of a field is the decimal point of the digit before it
+        if ((fieldIndex > 0) && (config->separator != MAX7219_CLOCK_SEPARATOR_NONE)) {
+            bool firstSeparator = fieldIndex == fieldCount - 1;
+            if (!firstSeparator || (config->separator == MAX7219_CLOCK_SEPARATOR_STEADY) || separatorLit) {
+                codes[2 * fieldIndex] |= MAX7219_SEGMENT_DP;
+            }
+        }
+    }
+
+    // 12 hour times blank the leading zero of the hours
+    bool timeLayout = (config->layout == MAX7219_CLOCK_LAYOUT_HH_MM) || (config->layout == MAX7219_CLOCK_LAYOUT_HH_MM_SS);
+    if (timeLayout && config->hour_12 && (hour < 10)) {
+        codes[clockWidget->digit_count - 1] = config->code_b ? MAX7219_CODE_B_BLANK : MAX7219_DIRECT_ADDRESSING_BLANK;
+    }
+
+    return send_changed_codes_private(clockWidget->handle, config->start_chain_id, config->start_digit_id, codes, clockWidget->shown, clockWidget->digit_count, &clockWidget->shown_valid, ticksToWait);
+}
+
+static bool clock_updating_private(max7219_clock_t* clockWidget) {
+    portENTER_CRITICAL(&clockWidget->lock);
+    bool updating = clockWidget->updating;
+    portEXIT_CRITICAL(&clockWidget->lock);
+    return updating;
+}
+
+static void clock_timer_callback(void* arg) {
+    max7219_clock_t* clockWidget = (max7219_clock_t*) arg;
+
+    // 'led_driver_max7219_clock_deinit()' waits for 'updating' to clear before it deletes the timer and clears the clock
+    portENTER_CRITICAL(&clockWidget->lock);
+    bool stopping = clockWidget->stopping;
+    clockWidget->updating = !stopping;
+    portEXIT_CRITICAL(&clockWidget->lock);
+    if (stopping) {
+        return;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    struct tm localTime;
+    localtime_r(&now.tv_sec, &localTime);
+
+    // Wake up on the next second, or half second, boundary so digits change when the time does
+    uint32_t periodUs = clockWidget->config.separator == MAX7219_CLOCK_SEPARATOR_BLINK ? CLOCK_HALF_SECOND_US : CLOCK_SECOND_US;
+    uint64_t timeoutUs = periodUs - (now.tv_usec % periodUs);
+
+    // Do not block the timer task on a busy driver - Try again shortly instead
+    esp_err_t err = show_clock_private(clockWidget, &localTime, now.tv_usec < CLOCK_HALF_SECOND_US, 0);
+    if (err == ESP_ERR_TIMEOUT) {
+        timeoutUs = timeoutUs < CLOCK_RETRY_US ? timeoutUs : CLOCK_RETRY_US;
+    } else if (err != ESP_OK) {
+        ESP_LOGW(LedDriverMax7219WidgetsLogTag, "Failed to update clock (%d)", err);
+    }
+    esp_timer_start_once(clockWidget->timer, timeoutUs);
+
+    portENTER_CRITICAL(&clockWidget->lock);
+    clockWidget->updating = false;
+    portEXIT_CRITICAL(&clockWidget->lock);
+}
@@ -22,6 +22,7 @@
 ##
 ## 2022/07/05 DreamSourceLab : Support for different data output formats
 ## 2024/12/01 Gilles Zunino: Support chained MAX7219 / MAX7221. Display device index. Correct intensity value based on chip. Various bug fixes
+## 2026/10/18 Gilles Zunino: Rebuild every device state at each LOAD edge. Display and bus efficiency annotations
 ##
 
 
@@ -61,6 +62,11 @@ ann_reg = 0
 ann_digit = 1
 ann_invalid = 2
 ann_device_index = 3
+ann_display = 4
+ann_efficiency = 5
+
+# Registers tracked to rebuild what each device displays
+tracked_registers = (0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0F)
 
 class Decoder(srd.Decoder):
     api_version = 3
@@ -74,17 +80,22 @@ class Decoder(srd.Decoder):
     tags = ['Display']
     options = (
         { 'id' : 'device_type' , 'desc' : 'Device type', 'default' : 'MAX7219', 'values' : ( 'MAX7219' , 'MAX7221' ) },
-        { 'id' : 'chain_length' , 'desc' : 'Device count', 'default' : 1 }
+        { 'id' : 'chain_length' , 'desc' : 'Device count', 'default' : 1 },
+        { 'id' : 'digit_order' , 'desc' : 'Display digit order', 'default' : 'Digit 8 first', 'values' : ( 'Digit 8 first' , 'Digit 1 first' ) }
     )
     annotations = (
         ('4', 'register', 'Registers written to the device'),
         ('10', 'digit', 'Digits displayed on the device'),
         ('0', 'invalid', 'Invalid register'),
-        ('14', 'device', 'Device index')
+        ('14', 'device', 'Device index'),
+        ('6', 'display', 'Display state of every device after LOAD'),
+        ('2', 'efficiency', 'Useful / redundant / no-op commands latched and bus occupancy since the previous LOAD')
     )
     annotation_rows = (
         ('commands', 'Commands', (ann_reg, ann_digit, ann_invalid)),
         ('device', 'Device', (ann_device_index,)),
+        ('display', 'Display', (ann_display,)),
+        ('efficiency', 'Efficiency', (ann_efficiency,)),
     )
 
     def __init__(self):
@@ -93,11 +104,26 @@ class Decoder(srd.Decoder):
     def reset(self):
         self.pos = 0
         self.cs_start = 0
+        self.cs_asserted = False
+        self.samplerate = None
+        self.shift_registers = None
+        self.devices = None
+        self.previous_latch = None
+        self.busy_samples = 0
 
     def start(self):
         self.out_ann = self.register(srd.OUTPUT_ANN)
         self.device_index = self.options['chain_length']
 
+        # 'shift_registers[0]' is the (address, data) held by the first device of the chain, None until 16 bits were shifted in
+        # 'devices[0]' maps register addresses of the first device to their last latched value
+        self.shift_registers = [None] * self.options['chain_length']
+        self.devices = [{} for _ in range(self.options['chain_length'])]
+
+    def metadata(self, key, value):
+        if key == srd.SRD_CONF_SAMPLERATE:
+            self.samplerate = value
+
     def putreg(self, ss, es, value):
         self.put(ss, es, self.out_ann, [ann_reg, ['%s' % value]])
 
@@ -119,6 +145,83 @@ class Decoder(srd.Decoder):
     def putdevice_index(self, ss, es, index):
         self.put(ss, es, self.out_ann, [ann_device_index, ['Device %d' % index]])
 
+    def putdisplay(self, ss, es):
+        devices = ['Device %d: %s' % (index + 1, self.render_device(device)) for index, device in enumerate(self.devices)]
+        self.put(ss, es, self.out_ann, [ann_display, [' | '.join(devices)]])
+
+    def putefficiency(self, ss, es, useful, redundant, noop):
+        commands = '%d useful, %d redundant, %d no-op' % (useful, redundant, noop)
+        if self.previous_latch is None or es <= self.previous_latch:
+            self.put(ss, es, self.out_ann, [ann_efficiency, [commands, '%d/%d/%d' % (useful, redundant, noop)]])
+            return
+
+        # Occupancy is the share of time spent shifting bits since the previous LOAD edge
+        period = es - self.previous_latch
+        occupancy = 100.0 * self.busy_samples / period
+        if self.samplerate:
+            timing = 'bus %.1f%% (%s busy / %s)' % (occupancy, self.format_time(self.busy_samples), self.format_time(period))
+        else:
+            timing = 'bus %.1f%%' % occupancy
+        self.put(ss, es, self.out_ann, [ann_efficiency, ['%s | %s' % (commands, timing), '%d/%d/%d %.0f%%' % (useful, redundant, noop, occupancy)]])
+
+    def format_time(self, samples):
+        seconds = samples / self.samplerate
+        if seconds >= 1e-3:
+            return '%.3f ms' % (seconds * 1e3)
+        return '%.1f us' % (seconds * 1e6)
+
+    def render_digit(self, device, digit):
+        value = device.get(digit)
+        if value is None:
+            return '?'
+
+        decode = device.get(0x09, 0x00)
+        if decode & (1 << (digit - 1)):
+            # Code B ignores bits 4 to 6
+            symbol = code_b_digits[value & 0x0F]
+            return (symbol if symbol != '' else ' ') + ('.' if value & 0x80 else '')
+        return '[%02X]' % value
+
+    def render_device(self, device):
+        if device.get(0x0F, 0x00) & 0x01:
+            return 'test'
+        if (device.get(0x0C) is None) or (device.get(0x0C) & 0x01) == 0:
+            return 'off'
+
+        # Digits beyond the scan limit are not displayed
+        digits = range(1, (device.get(0x0B, 0x07) & 0x07) + 2)
+        if self.options['digit_order'] == 'Digit 8 first':
+            digits = reversed(digits)
+        return "'%s'" % ''.join(self.render_digit(device, digit) for digit in digits)
+
+    def shift_command(self, address, data):
+        # Each device passes the 16 bits it held to the next device in the chain
+        self.shift_registers = [(address, data)] + self.shift_registers[:-1]
+
+    def latch(self, ss, es):
+        # On LOAD / CS rising edge, every device latches whatever its shift register holds
+        useful = redundant = noop = 0
+        for index, held in enumerate(self.shift_registers):
+            if held is None:
+                continue
+
+            address, data = held
+            if address == 0x00:
+                noop += 1
+            elif address not in tracked_registers:
+                continue
+            elif self.devices[index].get(address) == data:
+                redundant += 1
+            else:
+                useful += 1
+                self.devices[index][address] = data
+
+        self.putdisplay(ss, es)
+        self.putefficiency(ss, es, useful, redundant, noop)
+
+        self.previous_latch = es
+        self.busy_samples = 0
+
     def decode_mode(self, mode):
         decode_mode = mode & 0xFF
         if decode_mode == 0x00:
@@ -158,6 +261,8 @@ class Decoder(srd.Decoder):
             if not self.cs_asserted:
                 return
 
+            self.busy_samples += es - ss
+
             if self.pos == 0:
                 self.addr = mosi
                 self.addr_start = ss
@@ -183,6 +288,7 @@ class Decoder(srd.Decoder):
                         self.putinvalid(self.addr_start, es, 'INVALID REGISTER 0xX%01X' % sanitized_address)
 
                 self.putdevice_index(self.addr_start, es, self.device_index)
+                self.shift_command(self.addr & 0x0F, mosi)
 
                 self.pos = 0
                 self.device_index -= 1
@@ -190,9 +296,12 @@ class Decoder(srd.Decoder):
                     self.device_index = self.options['chain_length']
 
         elif ptype == 'CS-CHANGE':
+            was_asserted = self.cs_asserted
             self.cs_asserted = mosi
             if self.cs_asserted:
                 self.pos = 0
                 self.cs_start = ss
                 self.device_index = self.options['chain_length']
+            elif was_asserted:
+                self.latch(self.cs_start, es)
 
@@ -0,0 +1,601 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+//
+// Compile monochrome images and text into C arrays for LED matrix chains, so firmware shows static assets without rendering anything:
+//  * Images are PBM files (P1 or P4) - A file with several images back to back is a sequence of frames, as are several files,
+//  * Text is drawn with a 5x7 font, either as one frame or scrolling from right to left one column per frame,
+//  * Frames are laid on a canvas of modules - Row major from the top left module, the first module on device 'start_chain_id'.
+//
+// Output is either:
+//  * Wire frames for `led_driver_max7219_send_wire_frames()` - Eight chain transfers per frame, one per digit register, in wire order
+//    for the chain length and module orientation. Identical transfers are stored once and shared between frames,
+//  * Or, with -a, an animation for `led_driver_max7219_animation_init()` - Key frames and run length encoded XOR deltas.
+//
+// Usage: max7219_assets -c chain_length [-s start_chain_id] [-w modules_per_row] [-r module_rows] [-m orientation]
+//                       [-n name] [-t text] [-S] [-a frame_ms] [-o output.c] [image.pbm ...]
+//
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "max7219_7221_orientation.h"
+
+
+// Animation format, see `max7219_7221_animation.h`
+#define ANIMATION_VERSION 1
+#define ANIMATION_KEY_FRAME 0x00
+#define ANIMATION_DELTA_FRAME 0x01
+#define ANIMATION_MAX_DIGITS (255 * 8)
+
+#define RLE_MAX_COUNT 128
+#define RLE_RUN_FLAG 0x80
+
+#define FONT_FIRST_CHAR 0x20
+#define FONT_LAST_CHAR 0x7E
+#define FONT_WIDTH 5
+#define FONT_ADVANCE 6
+
+// 5x7 font from space to '~' - One byte per column, bit 0 is the top row
+static const uint8_t Font5x7[FONT_LAST_CHAR - FONT_FIRST_CHAR + 1][FONT_WIDTH] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 }
+};
+
+typedef struct {
+    max7219_orientation_t orientation;
+    const char* name;
+} orientation_name_t;
+
+static const orientation_name_t Orientations[] = {
+    { MAX7219_ORIENTATION_NORMAL, "normal" },
+    { MAX7219_ORIENTATION_MIRROR_X, "mirror_x" },
+    { MAX7219_ORIENTATION_MIRROR_Y, "mirror_y" },
+    { MAX7219_ORIENTATION_TRANSPOSE, "transpose" },
+    { MAX7219_ORIENTATION_ROTATE_90, "rotate_90" },
+    { MAX7219_ORIENTATION_ROTATE_180, "rotate_180" },
+    { MAX7219_ORIENTATION_ROTATE_270, "rotate_270" },
+    { MAX7219_ORIENTATION_ANTI_TRANSPOSE, "anti_transpose" }
+};
+
+#define ORIENTATION_COUNT (sizeof(Orientations) / sizeof(Orientations[0]))
+
+typedef struct {
+    // Chain and canvas geometry
+    unsigned chain_length;
+    unsigned start_chain_id;
+    unsigned modules_per_row;
+    unsigned module_rows;
+    max7219_orientation_t orientation;
+    unsigned width;
+    unsigned height;
+    unsigned stride;
+
+    // Frames, 'stride' bytes per canvas row, most significant bit on the left
+    uint8_t* frames;
+    size_t frame_count;
+    size_t frame_capacity;
+} assets_t;
+
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+} buffer_t;
+
+
+static void* checked_realloc(void* memory, size_t size) {
+    void* grown = realloc(memory, size);
+    if (grown == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return grown;
+}
+
+static void buffer_append(buffer_t* buffer, const uint8_t* data, size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        buffer->capacity = (buffer->length + length) * 2;
+        buffer->data = checked_realloc(buffer->data, buffer->capacity);
+    }
+    memcpy(&buffer->data[buffer->length], data, length);
+    buffer->length += length;
+}
+
+static void buffer_append_byte(buffer_t* buffer, uint8_t value) {
+    buffer_append(buffer, &value, 1);
+}
+
+static uint8_t* new_frame(assets_t* assets) {
+    size_t frameSize = (size_t) assets->stride * assets->height;
+    if (assets->frame_count == assets->frame_capacity) {
+        assets->frame_capacity = assets->frame_capacity > 0 ? assets->frame_capacity * 2 : 16;
+        assets->frames = checked_realloc(assets->frames, assets->frame_capacity * frameSize);
+    }
+    uint8_t* frame = &assets->frames[assets->frame_count++ * frameSize];
+    memset(frame, 0, frameSize);
+    return frame;
+}
+
+static void set_pixel(const assets_t* assets, uint8_t* frame, long x, long y) {
+    // Images larger than the canvas are cropped on the right and at the bottom
+    if ((x >= 0) && (y >= 0) && ((unsigned long) x < assets->width) && ((unsigned long) y < assets->height)) {
+        frame[y * assets->stride + x / 8] |= 0x80 >> (x % 8);
+    }
+}
+
+
+
+static int skip_space_and_comments(FILE* file) {
+    int c = fgetc(file);
+    while ((c != EOF) && (isspace(c) || (c == '#'))) {
+        if (c == '#') {
+            while ((c != EOF) && (c != '\n')) {
+                c = fgetc(file);
+            }
+        }
+        c = fgetc(file);
+    }
+    return c;
+}
+
+static bool read_header_number(FILE* file, unsigned* value) {
+    int c = skip_space_and_comments(file);
+    if (!isdigit(c)) {
+        return false;
+    }
+    *value = 0;
+    while (isdigit(c)) {
+        *value = *value * 10 + (c - '0');
+        c = fgetc(file);
+    }
+    // A single whitespace ends the header of P4 images
+    return (c == EOF) || isspace(c);
+}
+
+static bool load_pbm(assets_t* assets, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open '%s'\n", path);
+        return false;
+    }
+
+    // A file may hold several images back to back, each is a frame
+    unsigned imageCount = 0;
+    int c;
+    while ((c = skip_space_and_comments(file)) != EOF) {
+        int format = fgetc(file);
+        unsigned width = 0;
+        unsigned height = 0;
+        if ((c != 'P') || ((format != '1') && (format != '4')) || !read_header_number(file, &width) || !read_header_number(file, &height)) {
+            fprintf(stderr, "'%s': image %u is not a P1 or P4 PBM image\n", path, imageCount + 1);
+            fclose(file);
+            return false;
+        }
+
+        // P4 rows start on a byte boundary
+        uint8_t* frame = new_frame(assets);
+        int packed = 0;
+        for (unsigned y = 0; y < height; y++) {
+            for (unsigned x = 0; x < width; x++) {
+                bool on;
+                if (format == '1') {
+                    c = skip_space_and_comments(file);
+                    if ((c != '0') && (c != '1')) {
+                        fprintf(stderr, "'%s': image %u is truncated\n", path, imageCount + 1);
+                        fclose(file);
+                        return false;
+                    }
+                    on = c == '1';
+                } else {
+                    if (x % 8 == 0) {
+                        packed = fgetc(file);
+                        if (packed == EOF) {
+                            fprintf(stderr, "'%s': image %u is truncated\n", path, imageCount + 1);
+                            fclose(file);
+                            return false;
+                        }
+                    }
+                    on = (packed & (0x80 >> (x % 8))) != 0;
+                }
+                if (on) {
+                    set_pixel(assets, frame, x, y);
+                }
+            }
+        }
+        imageCount++;
+    }
+
+    fclose(file);
+    if (imageCount == 0) {
+        fprintf(stderr, "'%s' holds no image\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void draw_text(const assets_t* assets, uint8_t* frame, const char* text, long x) {
+    // Glyphs are 7 rows high and centered vertically on the canvas
+    long top = ((long) assets->height - 7) / 2;
+    for (const char* character = text; *character != '\0'; character++, x += FONT_ADVANCE) {
+        unsigned char code = (unsigned char) *character;
+        const uint8_t* glyph = Font5x7[((code >= FONT_FIRST_CHAR) && (code <= FONT_LAST_CHAR) ? code : '?') - FONT_FIRST_CHAR];
+        for (long column = 0; column < FONT_WIDTH; column++) {
+            for (long row = 0; row < 7; row++) {
+                if (glyph[column] & (1 << row)) {
+                    set_pixel(assets, frame, x + column, top + row);
+                }
+            }
+        }
+    }
+}
+
+static void add_text(assets_t* assets, const char* text, bool scroll) {
+    if (!scroll) {
+        draw_text(assets, new_frame(assets), text, 0);
+        return;
+    }
+
+    // Text comes in from the right edge and leaves by the left edge, one column per frame
+    long textWidth = (long) strlen(text) * FONT_ADVANCE;
+    for (long x = assets->width; x > -textWidth; x--) {
+        draw_text(assets, new_frame(assets), text, x);
+    }
+}
+
+
+
+static void module_registers(const assets_t* assets, const uint8_t* frame, unsigned moduleIndex, uint8_t registers[8]) {
+    // Digit registers of a module, with the orientation the module is mounted with
+    unsigned moduleColumn = moduleIndex % assets->modules_per_row;
+    unsigned moduleRow = moduleIndex / assets->modules_per_row;
+    uint8_t rows[8];
+    for (unsigned row = 0; row < 8; row++) {
+        rows[row] = frame[(moduleRow * 8 + row) * assets->stride + moduleColumn];
+    }
+    max7219_unpack_rows(max7219_orient(max7219_pack_rows(rows), assets->orientation), registers);
+}
+
+static void encode_wire_frames(const assets_t* assets, const uint8_t* frame, uint8_t* wireFrames) {
+    // Eight transfers, one per digit register - Within a transfer, the command for the last device goes first
+    unsigned moduleCount = assets->modules_per_row * assets->module_rows;
+    unsigned wireFrameSize = assets->chain_length * 2;
+    memset(wireFrames, 0, 8 * wireFrameSize);
+    for (unsigned moduleIndex = 0; moduleIndex < moduleCount; moduleIndex++) {
+        uint8_t registers[8];
+        module_registers(assets, frame, moduleIndex, registers);
+        unsigned wireIndex = assets->chain_length - (assets->start_chain_id + moduleIndex);
+        for (unsigned digit = 0; digit < 8; digit++) {
+            wireFrames[digit * wireFrameSize + wireIndex * 2] = digit + 1;
+            wireFrames[digit * wireFrameSize + wireIndex * 2 + 1] = registers[digit];
+        }
+    }
+}
+
+static void encode_digit_codes(const assets_t* assets, const uint8_t* frame, uint8_t* codes) {
+    // Codes in the order of `led_driver_max7219_set_digits()` - Digit 1 to 8 of each module in turn
+    unsigned moduleCount = assets->modules_per_row * assets->module_rows;
+    for (unsigned moduleIndex = 0; moduleIndex < moduleCount; moduleIndex++) {
+        module_registers(assets, frame, moduleIndex, &codes[moduleIndex * 8]);
+    }
+}
+
+static void rle_encode(buffer_t* output, const uint8_t* data, size_t length) {
+    // Runs of 3 or more bytes, or of 2 bytes outside of a literal, are runs - Anything else goes into literals
+    size_t index = 0;
+    size_t literalStart = 0;
+    while (index <= length) {
+        size_t run = 1;
+        while ((index + run < length) && (run < RLE_MAX_COUNT) && (data[index + run] == data[index])) {
+            run++;
+        }
+        bool endOfData = index == length;
+        bool startRun = !endOfData && ((run >= 3) || ((run == 2) && (literalStart == index)));
+        if ((endOfData || startRun) && (literalStart < index)) {
+            for (size_t start = literalStart; start < index; start += RLE_MAX_COUNT) {
+                size_t count = index - start < RLE_MAX_COUNT ? index - start : RLE_MAX_COUNT;
+                buffer_append_byte(output, (uint8_t) (count - 1));
+                buffer_append(output, &data[start], count);
+            }
+        }
+        if (endOfData) {
+            break;
+        }
+        if (startRun) {
+            buffer_append_byte(output, (uint8_t) (RLE_RUN_FLAG | (run - 1)));
+            buffer_append_byte(output, data[index]);
+            index += run;
+            literalStart = index;
+        } else {
+            index++;
+        }
+    }
+}
+
+
+
+static void write_bytes(FILE* output, const uint8_t* data, size_t length, const char* indent) {
+    for (size_t index = 0; index < length; index++) {
+        fprintf(output, "%s0x%02X,%s", index % 16 == 0 ? indent : "", data[index], (index % 16 == 15) || (index + 1 == length) ? "\n" : " ");
+    }
+}
+
+static void write_wire_frames(const assets_t* assets, const char* name, FILE* output) {
+    unsigned wireFrameSize = assets->chain_length * 2;
+    uint8_t* encoded = checked_realloc(NULL, 8 * wireFrameSize);
+    uint8_t* rows = NULL;
+    size_t rowCount = 0;
+    size_t* rowIndexes = checked_realloc(NULL, assets->frame_count * 8 * sizeof(size_t));
+
+    // Identical transfers, within a frame or across frames, are stored once
+    for (size_t frameIndex = 0; frameIndex < assets->frame_count; frameIndex++) {
+        encode_wire_frames(assets, &assets->frames[frameIndex * assets->stride * assets->height], encoded);
+        for (unsigned digit = 0; digit < 8; digit++) {
+            const uint8_t* wireFrame = &encoded[digit * wireFrameSize];
+            size_t rowIndex = 0;
+            while ((rowIndex < rowCount) && (memcmp(&rows[rowIndex * wireFrameSize], wireFrame, wireFrameSize) != 0)) {
+                rowIndex++;
+            }
+            if (rowIndex == rowCount) {
+                rows = checked_realloc(rows, (rowCount + 1) * wireFrameSize);
+                memcpy(&rows[rowCount++ * wireFrameSize], wireFrame, wireFrameSize);
+            }
+            rowIndexes[frameIndex * 8 + digit] = rowIndex;
+        }
+    }
+
+    fprintf(output, "// %zu frames, %zu unique chain transfers of %u bytes\n", assets->frame_count, rowCount, wireFrameSize);
+    fprintf(output, "// extern const uint8_t* const %s_frames[%zu][8];\n", name, assets->frame_count);
+    fprintf(output, "// ESP_ERROR_CHECK(led_driver_max7219_send_wire_frames(handle, %s_frames[frameIndex], 8));\n\n", name);
+    fprintf(output, "#include <stdint.h>\n\n");
+    fprintf(output, "static const uint8_t %s_transfers[%zu][%u] = {\n", name, rowCount, wireFrameSize);
+    for (size_t rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+        fprintf(output, "    {\n");
+        write_bytes(output, &rows[rowIndex * wireFrameSize], wireFrameSize, "        ");
+        fprintf(output, "    },\n");
+    }
+    fprintf(output, "};\n\n");
+    fprintf(output, "const uint8_t* const %s_frames[%zu][8] = {\n", name, assets->frame_count);
+    for (size_t frameIndex = 0; frameIndex < assets->frame_count; frameIndex++) {
+        fprintf(output, "    {");
+        for (unsigned digit = 0; digit < 8; digit++) {
+            fprintf(output, " %s_transfers[%zu]%s", name, rowIndexes[frameIndex * 8 + digit], digit < 7 ? "," : " ");
+        }
+        fprintf(output, "},\n");
+    }
+    fprintf(output, "};\n");
+
+    fprintf(stderr, "%zu frames, %zu unique transfers, %zu bytes of transfers instead of %zu\n",
+            assets->frame_count, rowCount, rowCount * wireFrameSize, assets->frame_count * 8 * wireFrameSize);
+    free(rowIndexes);
+    free(rows);
+    free(encoded);
+}
+
+static void write_animation(const assets_t* assets, const char* name, unsigned frameMs, FILE* output) {
+    unsigned digitCount = assets->modules_per_row * assets->module_rows * 8;
+    uint8_t* previous = checked_realloc(NULL, digitCount);
+    uint8_t* codes = checked_realloc(NULL, digitCount);
+    uint8_t* delta = checked_realloc(NULL, digitCount);
+
+    buffer_t animation = { 0 };
+    const uint8_t header[] = {
+        'M', '7', ANIMATION_VERSION, 0,
+        digitCount & 0xFF, digitCount >> 8,
+        assets->frame_count & 0xFF, (assets->frame_count >> 8) & 0xFF,
+        frameMs & 0xFF, (frameMs >> 8) & 0xFF
+    };
+    buffer_append(&animation, header, sizeof(header));
+
+    // Each frame is stored as a key frame or as a delta, whichever is smaller - The first frame is always a key frame
+    for (size_t frameIndex = 0; frameIndex < assets->frame_count; frameIndex++) {
+        encode_digit_codes(assets, &assets->frames[frameIndex * assets->stride * assets->height], codes);
+        buffer_t key = { 0 };
+        rle_encode(&key, codes, digitCount);
+
+        buffer_t xor = { 0 };
+        if (frameIndex > 0) {
+            for (unsigned index = 0; index < digitCount; index++) {
+                delta[index] = codes[index] ^ previous[index];
+            }
+            rle_encode(&xor, delta, digitCount);
+        }
+
+        bool useDelta = (frameIndex > 0) && (xor.length < key.length);
+        buffer_append_byte(&animation, useDelta ? ANIMATION_DELTA_FRAME : ANIMATION_KEY_FRAME);
+        buffer_append(&animation, useDelta ? xor.data : key.data, useDelta ? xor.length : key.length);
+        memcpy(previous, codes, digitCount);
+        free(key.data);
+        free(xor.data);
+    }
+
+    fprintf(output, "// %zu frames of %u digits, %zu bytes\n", assets->frame_count, digitCount, animation.length);
+    fprintf(output, "// extern const uint8_t %s[];\n// extern const size_t %s_size;\n\n", name, name);
+    fprintf(output, "#include <stddef.h>\n#include <stdint.h>\n\n");
+    fprintf(output, "const uint8_t %s[%zu] = {\n", name, animation.length);
+    write_bytes(output, animation.data, animation.length, "    ");
+    fprintf(output, "};\n\nconst size_t %s_size = sizeof(%s);\n", name, name);
+
+    fprintf(stderr, "%zu frames, %zu bytes instead of %zu\n", assets->frame_count, animation.length, assets->frame_count * digitCount);
+    free(animation.data);
+    free(delta);
+    free(codes);
+    free(previous);
+}
+
+
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s -c chain_length [-s start_chain_id] [-w modules_per_row] [-r module_rows] [-m orientation]\n", program);
+    fprintf(stderr, "       %*s [-n name] [-t text] [-S] [-a frame_ms] [-o output.c] [image.pbm ...]\n", (int) strlen(program), "");
+    fprintf(stderr, "Orientations:");
+    for (size_t index = 0; index < ORIENTATION_COUNT; index++) {
+        fprintf(stderr, " %s", Orientations[index].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+static bool valid_identifier(const char* name) {
+    if (!isalpha((unsigned char) name[0]) && (name[0] != '_')) {
+        return false;
+    }
+    for (const char* character = name; *character != '\0'; character++) {
+        if (!isalnum((unsigned char) *character) && (*character != '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    assets_t assets = { .start_chain_id = 1, .module_rows = 1, .orientation = MAX7219_ORIENTATION_NORMAL };
+    const char* name = "max7219_asset";
+    const char* text = NULL;
+    const char* outputPath = NULL;
+    bool scroll = false;
+    bool animation = false;
+    unsigned frameMs = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "c:s:w:r:m:n:t:Sa:o:h")) != -1) {
+        switch (option) {
+            case 'c':
+                assets.chain_length = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                assets.start_chain_id = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 'w':
+                assets.modules_per_row = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                assets.module_rows = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 'm': {
+                size_t index = 0;
+                while ((index < ORIENTATION_COUNT) && (strcmp(optarg, Orientations[index].name) != 0)) {
+                    index++;
+                }
+                if (index == ORIENTATION_COUNT) {
+                    fprintf(stderr, "Unknown orientation '%s'\n", optarg);
+                    usage(argv[0]);
+                    return 2;
+                }
+                assets.orientation = Orientations[index].orientation;
+            }
+            break;
+            case 'n':
+                name = optarg;
+                break;
+            case 't':
+                text = optarg;
+                break;
+            case 'S':
+                scroll = true;
+                break;
+            case 'a':
+                animation = true;
+                frameMs = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return option == 'h' ? 0 : 2;
+        }
+    }
+
+    // The canvas defaults to one row of modules from the start device to the end of the chain
+    if ((assets.modules_per_row == 0) && (assets.chain_length >= assets.start_chain_id)) {
+        assets.modules_per_row = assets.chain_length - assets.start_chain_id + 1;
+    }
+    if ((assets.chain_length == 0) || (assets.chain_length > 255) || (assets.start_chain_id == 0) || (assets.modules_per_row == 0) || (assets.module_rows == 0) ||
+        (assets.start_chain_id - 1 + assets.modules_per_row * assets.module_rows > assets.chain_length)) {
+        fprintf(stderr, "The chain must have 1 to 255 devices and the canvas must fit on the chain from the start device\n");
+        usage(argv[0]);
+        return 2;
+    }
+    if (!valid_identifier(name)) {
+        fprintf(stderr, "'%s' is not a valid C identifier\n", name);
+        return 2;
+    }
+    if ((text == NULL) && (optind == argc)) {
+        fprintf(stderr, "Nothing to compile - Give images and / or text\n");
+        usage(argv[0]);
+        return 2;
+    }
+    if (animation && ((frameMs > UINT16_MAX) || (assets.modules_per_row * assets.module_rows * 8 > ANIMATION_MAX_DIGITS))) {
+        fprintf(stderr, "Animations have up to %d digits per frame and up to %d ms between frames\n", ANIMATION_MAX_DIGITS, UINT16_MAX);
+        return 2;
+    }
+
+    assets.width = assets.modules_per_row * 8;
+    assets.height = assets.module_rows * 8;
+    assets.stride = assets.modules_per_row;
+
+    for (int argument = optind; argument < argc; argument++) {
+        if (!load_pbm(&assets, argv[argument])) {
+            free(assets.frames);
+            return 1;
+        }
+    }
+    if (text != NULL) {
+        add_text(&assets, text, scroll);
+    }
+    if (animation && (assets.frame_count > UINT16_MAX)) {
+        fprintf(stderr, "Animations have up to %d frames\n", UINT16_MAX);
+        free(assets.frames);
+        return 2;
+    }
+
+    FILE* output = outputPath != NULL ? fopen(outputPath, "w") : stdout;
+    if (output == NULL) {
+        fprintf(stderr, "Cannot create '%s'\n", outputPath);
+        free(assets.frames);
+        return 1;
+    }
+
+    fprintf(output, "// Generated by max7219_assets - Do not edit\n");
+    fprintf(output, "// Chain of %u devices, %u x %u modules from device %u, orientation %u\n",
+            assets.chain_length, assets.modules_per_row, assets.module_rows, assets.start_chain_id, (unsigned) assets.orientation);
+    if (animation) {
+        write_animation(&assets, name, frameMs, output);
+    } else {
+        write_wire_frames(&assets, name, output);
+    }
+
+    if (output != stdout) {
+        fclose(output);
+    }
+    free(assets.frames);
+    return 0;
+}
@@ -0,0 +1,157 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+//
+// Compare the 64 bit module orientation kernels of `max7219_7221_orientation.h` against a naive per pixel loop:
+//  * Check both give the same digit registers for every orientation on random modules,
+//  * Report the time to orient one module with each.
+//
+// Usage: max7219_orient_bench [-n modules] [-r rounds]
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "max7219_7221_orientation.h"
+
+
+typedef struct {
+    max7219_orientation_t orientation;
+    const char* name;
+} orientation_name_t;
+
+static const orientation_name_t Orientations[] = {
+    { MAX7219_ORIENTATION_NORMAL, "normal" },
+    { MAX7219_ORIENTATION_MIRROR_X, "mirror x" },
+    { MAX7219_ORIENTATION_MIRROR_Y, "mirror y" },
+    { MAX7219_ORIENTATION_TRANSPOSE, "transpose" },
+    { MAX7219_ORIENTATION_ROTATE_90, "rotate 90" },
+    { MAX7219_ORIENTATION_ROTATE_180, "rotate 180" },
+    { MAX7219_ORIENTATION_ROTATE_270, "rotate 270" },
+    { MAX7219_ORIENTATION_ANTI_TRANSPOSE, "anti transpose" }
+};
+
+#define ORIENTATION_COUNT (sizeof(Orientations) / sizeof(Orientations[0]))
+
+
+static void orient_naive(const uint8_t rows[8], max7219_orientation_t orientation, uint8_t registers[8]) {
+    // Pixel (row, column) of the registers comes from the module pixel found by undoing mirrors, then the transpose
+    memset(registers, 0, 8);
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            int sourceRow = (orientation & MAX7219_ORIENTATION_MIRROR_Y) ? 7 - row : row;
+            int sourceColumn = (orientation & MAX7219_ORIENTATION_MIRROR_X) ? 7 - column : column;
+            if (orientation & MAX7219_ORIENTATION_TRANSPOSE) {
+                int swap = sourceRow;
+                sourceRow = sourceColumn;
+                sourceColumn = swap;
+            }
+            if (rows[sourceRow] & (0x80 >> sourceColumn)) {
+                registers[row] |= 0x80 >> column;
+            }
+        }
+    }
+}
+
+static void orient_swar(const uint8_t rows[8], max7219_orientation_t orientation, uint8_t registers[8]) {
+    max7219_unpack_rows(max7219_orient(max7219_pack_rows(rows), orientation), registers);
+}
+
+static uint64_t next_random(uint64_t* state) {
+    // xorshift64*
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static double now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static double time_kernel(void (*kernel)(const uint8_t[8], max7219_orientation_t, uint8_t[8]), max7219_orientation_t orientation,
+                          const uint8_t* modules, size_t moduleCount, unsigned rounds, uint8_t* sink) {
+    uint8_t registers[8];
+    double startNs = now_ns();
+    for (unsigned round = 0; round < rounds; round++) {
+        for (size_t index = 0; index < moduleCount; index++) {
+            kernel(&modules[index * 8], orientation, registers);
+            *sink ^= registers[index % 8];
+        }
+    }
+    return (now_ns() - startNs) / ((double) rounds * moduleCount);
+}
+
+int main(int argc, char** argv) {
+    size_t moduleCount = 4096;
+    unsigned rounds = 200;
+
+    int option;
+    while ((option = getopt(argc, argv, "n:r:h")) != -1) {
+        switch (option) {
+            case 'n':
+                moduleCount = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                rounds = (unsigned) strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n modules] [-r rounds]\n", argv[0]);
+                return option == 'h' ? 0 : 2;
+        }
+    }
+
+    if ((moduleCount == 0) || (rounds == 0)) {
+        fprintf(stderr, "Usage: %s [-n modules] [-r rounds]\n", argv[0]);
+        return 2;
+    }
+
+    uint8_t* modules = malloc(moduleCount * 8);
+    if (modules == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (size_t index = 0; index < moduleCount * 8; index++) {
+        modules[index] = (uint8_t) next_random(&state);
+    }
+
+    // Both implementations must agree on every module
+    for (size_t orientationIndex = 0; orientationIndex < ORIENTATION_COUNT; orientationIndex++) {
+        for (size_t index = 0; index < moduleCount; index++) {
+            uint8_t expected[8];
+            uint8_t actual[8];
+            orient_naive(&modules[index * 8], Orientations[orientationIndex].orientation, expected);
+            orient_swar(&modules[index * 8], Orientations[orientationIndex].orientation, actual);
+            if (memcmp(expected, actual, sizeof(expected)) != 0) {
+                fprintf(stderr, "Mismatch for '%s' on module %zu\n", Orientations[orientationIndex].name, index);
+                free(modules);
+                return 1;
+            }
+        }
+    }
+
+    printf("%zu modules x %u rounds\n", moduleCount, rounds);
+    printf("%-16s %12s %12s %10s\n", "Orientation", "Naive ns", "SWAR ns", "Speedup");
+
+    uint8_t sink = 0;
+    for (size_t orientationIndex = 0; orientationIndex < ORIENTATION_COUNT; orientationIndex++) {
+        double naiveNs = time_kernel(orient_naive, Orientations[orientationIndex].orientation, modules, moduleCount, rounds, &sink);
+        double swarNs = time_kernel(orient_swar, Orientations[orientationIndex].orientation, modules, moduleCount, rounds, &sink);
+        printf("%-16s %12.2f %12.2f %9.1fx\n", Orientations[orientationIndex].name, naiveNs, swarNs, swarNs > 0 ? naiveNs / swarNs : 0.0);
+    }
+
+    // Keep the compiler from dropping the timed loops
+    printf("(checksum %02x)\n", sink);
+
+    free(modules);
+    return 0;
+}
@@ -0,0 +1,292 @@
+// -----------------------------------------------------------------------------------
+// Copyright 2024, Gilles Zunino
+// -----------------------------------------------------------------------------------
+//
+// Replay an SPI capture, see `led_driver_max7219_read_capture()`, through a model of the chain and report:
+//  * Transfer and frame rate - A frame is a burst of transfers separated by less than the frame gap,
+//  * Bus utilization - Time spent transmitting over the capture duration,
+//  * Useful, redundant (register already held that value) and no-op commands,
+//  * Worst gaps between the end of a transfer and the start of the next one.
+//
+// Usage: max7219_replay [-g frame_gap_us] [-n worst_gaps] capture.bin
+//
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "max7219_7221_capture.h"
+
+
+#define MAX7219_REGISTER_COUNT 16
+#define MAX_WORST_GAPS 64
+
+typedef struct {
+    uint8_t registers[MAX7219_REGISTER_COUNT];
+    uint16_t known_registers;
+} device_model_t;
+
+typedef struct {
+    uint64_t start_us;
+    uint64_t gap_us;
+} gap_t;
+
+typedef struct {
+    // Configuration
+    uint64_t frame_gap_us;
+    unsigned worst_gap_count;
+
+    // Chain model - 'devices[0]' is the first device of the chain
+    uint8_t chain_length;
+    uint32_t clock_speed_hz;
+    device_model_t* devices;
+
+    // Timeline - Capture timestamps are 32 bits and wrap every ~71 minutes
+    bool started;
+    uint32_t last_timestamp_us;
+    uint64_t first_start_us;
+    uint64_t last_start_us;
+    uint64_t last_end_us;
+
+    // Statistics
+    uint64_t transfers;
+    uint64_t frames;
+    uint64_t busy_us;
+    uint64_t wire_bits;
+    uint64_t useful_commands;
+    uint64_t redundant_commands;
+    uint64_t noop_commands;
+    uint64_t dropped_records;
+    gap_t worst_gaps[MAX_WORST_GAPS];
+    unsigned worst_gaps_used;
+} replay_t;
+
+
+static uint16_t read_u16(const uint8_t* p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void record_gap(replay_t* replay, uint64_t startUs, uint64_t gapUs) {
+    // Keep the worst gaps sorted, longest first
+    unsigned position = replay->worst_gaps_used;
+    while ((position > 0) && (replay->worst_gaps[position - 1].gap_us < gapUs)) {
+        position--;
+    }
+    if (position >= replay->worst_gap_count) {
+        return;
+    }
+
+    unsigned last = replay->worst_gaps_used < replay->worst_gap_count ? replay->worst_gaps_used++ : replay->worst_gap_count - 1;
+    memmove(&replay->worst_gaps[position + 1], &replay->worst_gaps[position], (last - position) * sizeof(gap_t));
+    replay->worst_gaps[position] = (gap_t) { .start_us = startUs, .gap_us = gapUs };
+}
+
+static void replay_transfer(replay_t* replay, uint32_t timestampUs, uint16_t durationUs, const uint8_t* commands) {
+    uint64_t startUs = replay->started ? replay->last_start_us + (uint32_t) (timestampUs - replay->last_timestamp_us) : 0;
+    if (!replay->started) {
+        replay->started = true;
+        replay->first_start_us = startUs;
+        replay->frames = 1;
+    } else {
+        uint64_t gapUs = startUs > replay->last_end_us ? startUs - replay->last_end_us : 0;
+        record_gap(replay, startUs, gapUs);
+        if (gapUs >= replay->frame_gap_us) {
+            replay->frames++;
+        }
+    }
+
+    replay->last_timestamp_us = timestampUs;
+    replay->last_start_us = startUs;
+    replay->last_end_us = startUs + durationUs;
+    replay->transfers++;
+    replay->busy_us += durationUs;
+    replay->wire_bits += replay->chain_length * 16;
+
+    // Commands are in wire order - The first command reaches the last device of the chain
+    for (uint8_t deviceIndex = 0; deviceIndex < replay->chain_length; deviceIndex++) {
+        uint8_t address = commands[2 * deviceIndex] & 0x0F;
+        uint8_t data = commands[2 * deviceIndex + 1];
+        device_model_t* device = &replay->devices[replay->chain_length - 1 - deviceIndex];
+
+        if (address == 0x00) {
+            replay->noop_commands++;
+        } else if ((device->known_registers & (1 << address)) && (device->registers[address] == data)) {
+            replay->redundant_commands++;
+        } else {
+            replay->useful_commands++;
+            device->registers[address] = data;
+            device->known_registers |= 1 << address;
+        }
+    }
+}
+
+static int replay_stream(replay_t* replay, const uint8_t* stream, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        if (size - offset < sizeof(max7219_capture_header_t)) {
+            fprintf(stderr, "Truncated chunk header at offset %zu\n", offset);
+            return 1;
+        }
+
+        const uint8_t* header = stream + offset;
+        uint32_t magic = read_u32(header + offsetof(max7219_capture_header_t, magic));
+        uint8_t version = header[offsetof(max7219_capture_header_t, version)];
+        uint8_t chainLength = header[offsetof(max7219_capture_header_t, chain_length)];
+        uint16_t recordCount = read_u16(header + offsetof(max7219_capture_header_t, record_count));
+        if ((magic != MAX7219_CAPTURE_MAGIC) || (version != MAX7219_CAPTURE_VERSION) || (chainLength == 0)) {
+            fprintf(stderr, "Invalid chunk header at offset %zu\n", offset);
+            return 1;
+        }
+
+        if (replay->devices == NULL) {
+            replay->chain_length = chainLength;
+            replay->clock_speed_hz = read_u32(header + offsetof(max7219_capture_header_t, clock_speed_hz));
+            replay->devices = calloc(chainLength, sizeof(device_model_t));
+            if (replay->devices == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+        } else if (chainLength != replay->chain_length) {
+            fprintf(stderr, "Chain length changes from %u to %u at offset %zu\n", replay->chain_length, chainLength, offset);
+            return 1;
+        }
+        replay->dropped_records += read_u32(header + offsetof(max7219_capture_header_t, dropped_records));
+        offset += sizeof(max7219_capture_header_t);
+
+        const size_t recordSize = sizeof(max7219_capture_record_t) + 2 * (size_t) chainLength;
+        if ((size - offset) / recordSize < recordCount) {
+            fprintf(stderr, "Truncated chunk at offset %zu\n", offset);
+            return 1;
+        }
+
+        for (uint16_t recordIndex = 0; recordIndex < recordCount; recordIndex++) {
+            const uint8_t* record = stream + offset;
+            replay_transfer(replay,
+                            read_u32(record + offsetof(max7219_capture_record_t, timestamp_us)),
+                            read_u16(record + offsetof(max7219_capture_record_t, duration_us)),
+                            record + sizeof(max7219_capture_record_t));
+            offset += recordSize;
+        }
+    }
+
+    return 0;
+}
+
+static void print_report(const replay_t* replay) {
+    if (replay->transfers == 0) {
+        printf("No transfers captured\n");
+        return;
+    }
+
+    uint64_t spanUs = replay->last_end_us - replay->first_start_us;
+    double spanS = spanUs / 1e6;
+    uint64_t commands = replay->useful_commands + replay->redundant_commands + replay->noop_commands;
+
+    printf("Chain length        : %u device(s)\n", replay->chain_length);
+    printf("SPI clock           : %u Hz\n", replay->clock_speed_hz);
+    printf("Capture duration    : %.3f ms\n", spanUs / 1e3);
+    printf("Transfers           : %llu (%.1f /s)\n", (unsigned long long) replay->transfers, spanS > 0 ? replay->transfers / spanS : 0.0);
+    printf("Frames              : %llu (%.1f /s, frame gap %llu us)\n", (unsigned long long) replay->frames, spanS > 0 ? replay->frames / spanS : 0.0, (unsigned long long) replay->frame_gap_us);
+    printf("Bus utilization     : %.1f %% (%llu us transmitting)\n", spanUs > 0 ? 100.0 * replay->busy_us / spanUs : 100.0, (unsigned long long) replay->busy_us);
+    if (replay->clock_speed_hz > 0) {
+        // Transfers handed to a bus coordinator are timed until queued, not until sent, and can take less than their wire time
+        double wireUs = 1e6 * replay->wire_bits / replay->clock_speed_hz;
+        if (replay->busy_us >= wireUs) {
+            printf("Wire time           : %.0f us (%.1f %% of transmit time is overhead)\n", wireUs, replay->busy_us > 0 ? 100.0 * (replay->busy_us - wireUs) / replay->busy_us : 0.0);
+        } else {
+            printf("Wire time           : %.0f us\n", wireUs);
+        }
+    }
+    printf("Commands            : %llu useful, %llu redundant, %llu no-op (%.1f %% of wire commands were useful)\n",
+            (unsigned long long) replay->useful_commands, (unsigned long long) replay->redundant_commands, (unsigned long long) replay->noop_commands,
+            100.0 * replay->useful_commands / commands);
+    if (replay->dropped_records > 0) {
+        printf("Dropped records     : %llu - The capture ring overflowed, figures are incomplete\n", (unsigned long long) replay->dropped_records);
+    }
+
+    printf("Worst gaps          :\n");
+    for (unsigned gapIndex = 0; gapIndex < replay->worst_gaps_used; gapIndex++) {
+        printf("  %10llu us at %.3f ms\n", (unsigned long long) replay->worst_gaps[gapIndex].gap_us, (replay->worst_gaps[gapIndex].start_us - replay->first_start_us) / 1e3);
+    }
+}
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    uint8_t* data = NULL;
+    size_t capacity = 0;
+    *size = 0;
+    for (;;) {
+        if (*size == capacity) {
+            capacity = capacity == 0 ? 64 * 1024 : capacity * 2;
+            uint8_t* grown = realloc(data, capacity);
+            if (grown == NULL) {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = grown;
+        }
+
+        size_t read = fread(data + *size, 1, capacity - *size, file);
+        if (read == 0) {
+            break;
+        }
+        *size += read;
+    }
+
+    fclose(file);
+    return data;
+}
+
+int main(int argc, char** argv) {
+    replay_t replay = { .frame_gap_us = 1000, .worst_gap_count = 5 };
+
+    int option;
+    while ((option = getopt(argc, argv, "g:n:h")) != -1) {
+        switch (option) {
+            case 'g':
+                replay.frame_gap_us = strtoull(optarg, NULL, 10);
+                break;
+            case 'n':
+                replay.worst_gap_count = (unsigned) strtoul(optarg, NULL, 10);
+                replay.worst_gap_count = replay.worst_gap_count > MAX_WORST_GAPS ? MAX_WORST_GAPS : replay.worst_gap_count;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-g frame_gap_us] [-n worst_gaps] capture.bin\n", argv[0]);
+                return option == 'h' ? 0 : 2;
+        }
+    }
+
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-g frame_gap_us] [-n worst_gaps] capture.bin\n", argv[0]);
+        return 2;
+    }
+
+    size_t size = 0;
+    uint8_t* stream = read_file(argv[optind], &size);
+    if (stream == NULL) {
+        fprintf(stderr, "Could not read '%s'\n", argv[optind]);
+        return 1;
+    }
+
+    int ret = replay_stream(&replay, stream, size);
+    if (ret == 0) {
+        print_report(&replay);
+    }
+
+    free(replay.devices);
+    free(stream);
+    return ret;
+}